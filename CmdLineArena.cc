@@ -0,0 +1,75 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineArena.cc
+  \brief
+
+  <long description>
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+
+#include "CmdLineArena.hh"
+
+CmdLineArena::CmdLineArena(size_t block)
+    : fBlockSize(block), fPos(nullptr), fEnd(nullptr), fNBytes(0) {}
+
+CmdLineArena::~CmdLineArena() { Clear(); }
+
+void* CmdLineArena::Allocate(size_t size, size_t align) {
+  size_t pad = (align - (uintptr_t)fPos % align) % align;
+  if (!fPos || (size_t)(fEnd - fPos) < pad + size) {
+    // large requests get a block of their own
+    size_t length = size + align > fBlockSize ? size + align : fBlockSize;
+    char* block = (char*)malloc(length);
+    if (!block) {
+      std::cerr << "CmdLineArena: out of memory" << std::endl;
+      abort();
+    }
+    fBlocks.push_back(block);
+    fNBytes += length;
+    fPos = block;
+    fEnd = block + length;
+    pad = (align - (uintptr_t)fPos % align) % align;
+  }
+  void* p = fPos + pad;
+  fPos += pad + size;
+  return p;
+}
+
+const char* CmdLineArena::Copy(const char* s, size_t n) {
+  char* p = (char*)Allocate(n + 1, 1);
+  if (n) memcpy(p, s, n);
+  p[n] = 0;
+  return p;
+}
+
+void CmdLineArena::Clear() {
+  for (size_t i = 0; i < fBlocks.size(); ++i)
+    free(fBlocks[i]);
+  fBlocks.clear();
+  fPos = fEnd = nullptr;
+  fNBytes = 0;
+}
+
+std::ostream& operator<<(std::ostream& os, const CmdLineName& name) {
+  return os << name.Data();
+}
@@ -0,0 +1,96 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineArena.hh
+  \brief  Storage of option names and expanded options
+
+  Names, help texts and tags of options are copied once into the arena of
+  their context and referred to by CmdLineName, which the map of options
+  uses as key as well. Options made by CmdLineOption::Expand() are placed in
+  the arena too; the memory is released with the context only.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINEARENA_HH
+#define _CMDLINEARENA_HH
+
+#include <cstring>
+#include <iosfwd>
+#include <string_view>
+#include <vector>
+
+#include <TString.h>
+
+class CmdLineArena {
+public:
+  CmdLineArena(size_t block = 65536);
+  virtual ~CmdLineArena();
+
+  void* Allocate(size_t size, size_t align = alignof(std::max_align_t));
+  /// Copy of the first n characters, terminated.
+  const char* Copy(const char* s, size_t n);
+  const char* Copy(const char* s) { return Copy(s, s ? strlen(s) : 0); }
+  /// Releases all memory at once.
+  void Clear();
+  /// Bytes taken from the heap.
+  size_t GetNBytes() const { return fNBytes; }
+
+private:
+  CmdLineArena(const CmdLineArena&) = delete;
+  CmdLineArena& operator=(const CmdLineArena&) = delete;
+
+  std::vector<char*> fBlocks;
+  size_t fBlockSize;
+  char* fPos; // free part of the last block
+  char* fEnd;
+  size_t fNBytes;
+};
+
+/// String stored elsewhere, compared by contents. Has the read-only part of
+/// the interface of TString used for names.
+class CmdLineName {
+public:
+  CmdLineName() : fData("") {}
+  explicit CmdLineName(const char* data) : fData(data ? data : "") {}
+
+  const char* Data() const { return fData; }
+  operator const char*() const { return fData; }
+  std::string_view View() const { return fData; }
+  Ssiz_t Length() const { return strlen(fData); }
+  Bool_t IsNull() const { return *fData == 0; }
+
+  bool operator==(const char* s) const { return strcmp(fData, s) == 0; }
+  bool operator!=(const char* s) const { return strcmp(fData, s) != 0; }
+  bool operator==(const CmdLineName& s) const { return *this == s.fData; }
+  bool operator!=(const CmdLineName& s) const { return *this != s.fData; }
+  bool operator==(const TString& s) const { return *this == s.Data(); }
+  bool operator!=(const TString& s) const { return *this != s.Data(); }
+
+private:
+  const char* fData;
+};
+
+inline TString operator+(const char* s, const CmdLineName& name) {
+  return TString(s) + name.Data();
+}
+inline TString operator+(const TString& s, const CmdLineName& name) {
+  return s + name.Data();
+}
+std::ostream& operator<<(std::ostream& os, const CmdLineName& name);
+
+#endif
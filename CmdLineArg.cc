@@ -41,6 +41,7 @@
 
 #include "CmdLineArg.hh"
 #include "CmdLineConfig.hh"
+#include "CmdLineRange.hh"
 
 const TString CmdLineArg::delim = ": ,";
 
@@ -61,11 +62,11 @@ CmdLineArg::CmdLineArg(const CmdLineArg& ref) {
 CmdLineArg::CmdLineArg() { Init(0, 0); };
 
 CmdLineArg::~CmdLineArg() {
-  TObject* obj =
-      CmdLineConfig::instance()->GetEnv()->Lookup("CmdLine." + fName);
-  if (obj) CmdLineConfig::instance()->GetEnv()->GetTable()->Remove(obj);
+  CmdLineBinding::Remove(this);
+  if (!fConfig) return;
 
-  if (!fName.IsNull()) CmdLineConfig::instance()->Remove(this);
+  fConfig->Erase("CmdLine." + fName);
+  if (!fName.IsNull()) fConfig->Remove(this);
 }
 
 CmdLineArg* CmdLineArg::Expand(TObject* obj) {
@@ -77,7 +78,7 @@ CmdLineArg* CmdLineArg::Expand(TObject* obj) {
 
 CmdLineArg* CmdLineArg::Expand(const TString& cname, const TString& name) {
   TString newname = cname + "." + name + "." + fName;
-  CmdLineArg* newopt = CmdLineConfig::instance()->FindArgument(newname);
+  CmdLineArg* newopt = CmdLineConfig::Current()->FindArgument(newname);
   if (newopt != 0) return newopt;
   return new CmdLineArg(newname, fType);
 }
@@ -87,8 +88,15 @@ void CmdLineArg::Init(const char* name, const char* help, bool greedy) {
   fHelp = help;
   fType = kNone;
   fFunction = 0;
+  fInt = 0;
+  fDouble = 0.;
+  fDefinition = nullptr;
 
-  if (!greedy) CmdLineConfig::instance()->Insert(this);
+  fConfig = nullptr;
+  if (greedy || !name) return;
+
+  fConfig = CmdLineConfig::Current();
+  fConfig->Insert(this);
 }
 
 const Int_t CmdLineArg::GetArraySizeFromString(const TString arraystring) {
@@ -128,6 +136,54 @@ CmdLineArg::GetDoubleArrayValueFromString(const TString arraystring,
 
 const char* CmdLineArg::GetHelp() const { return fHelp.Data(); };
 
+CmdLineBinding CmdLineArg::AddBinding(const CmdLineBinding::Writer& writer) {
+  return CmdLineBinding::Add(CmdLineConfig::Current(), this, writer);
+}
+
+// the value is that of the context the binding was made in, which may
+// have its own copy of the argument
+Double_t CmdLineArg::GetBoundNumber() {
+  CmdLineArg* arg = CmdLineConfig::Current()->FindArgument(fName);
+  if (!arg) arg = this;
+  if (arg->fType == kBool || arg->fType == kInt) return arg->fInt;
+  if (arg->fType == kDouble) return arg->fDouble;
+  return arg->fValue.Atof();
+}
+
+const char* CmdLineArg::GetBoundText() {
+  CmdLineArg* arg = CmdLineConfig::Current()->FindArgument(fName);
+  return arg ? arg->fValue.Data() : fValue.Data();
+}
+
+Bool_t CmdLineArg::SetValue(const char* value, const char* location,
+                            CmdLineRange* range) {
+  // numerical values are converted once, when the argument is set
+  fValue = value;
+  Bool_t ok;
+  if (range && fType == kInt) {
+    // ranges are appended to the list without expanding them
+    ULong64_t n = range->size();
+    ok = range->Parse(value);
+    fInts.clear();
+    fDoubles.clear();
+    fInt = range->size() > n ? range->At(n) : 0;
+    fDouble = 0.;
+  } else {
+    ok = CmdLineOption::ParseValue(value, (CmdLineOption::OptionType)fType,
+                                   fInts, fDoubles);
+    fInt = fInts.size() ? fInts[0] : 0;
+    fDouble = fDoubles.size() ? fDoubles[0] : 0.;
+  }
+  CmdLineBinding::Write(fConfig, fDefinition ? fDefinition : this);
+  if (ok) return kTRUE;
+
+  std::cerr << "CmdLineArg: invalid value '" << value << "' of "
+            << (fName.IsNull() ? "greedy argument" : fName.Data()) << " at "
+            << (location ? location : "configuration") << std::endl;
+  if (CmdLineOption::AbortOnWarning) abort();
+  return kFALSE;
+}
+
 const Bool_t CmdLineArg::GetFlagValue() const {
   if (fType != kFlag)
     std::cerr << "CmdLineArg: " << fName << " not defined as flag! "
@@ -140,6 +196,7 @@ const Bool_t CmdLineArg::GetBoolValue() const {
   if (fType != kBool)
     std::cerr << "CmdLineArg: " << fName << " not defined as bool! "
               << std::endl;
+  if (fType == kBool) return fInt == 1;
   return fValue.Atoi();
 }
 
@@ -147,10 +204,15 @@ const Int_t CmdLineArg::GetIntValue() const {
   if (fType != kInt)
     std::cerr << "CmdLineArg: " << fName << " not defined as integer!"
               << std::endl;
+  if (fType == kInt) return fInt;
   return fValue.Atoi();
 }
 
 const Int_t CmdLineArg::GetIntArrayValue(const Int_t index) {
+  if (fType == kInt) {
+    if (index >= 1 && index <= (Int_t)fInts.size()) return fInts[index - 1];
+    return 0;
+  }
   const TString arraystring = GetStringValue(kTRUE);
   return GetIntArrayValueFromString(arraystring, index);
 }
@@ -159,23 +221,31 @@ const Double_t CmdLineArg::GetDoubleValue() const {
   if (fType != kDouble)
     std::cerr << "CmdLineArg: " << fName << " not defined as double!"
               << std::endl;
+  if (fType == kDouble) return fDouble;
   return fValue.Atof();
 }
 
 const Double_t CmdLineArg::GetDoubleArrayValue(const Int_t index) {
+  if (fType == kDouble) {
+    if (index >= 1 && index <= (Int_t)fDoubles.size())
+      return fDoubles[index - 1];
+    return 0.;
+  }
   const TString arraystring = GetStringValue(kTRUE);
   return GetDoubleArrayValueFromString(arraystring, index);
 }
 
 const Int_t CmdLineArg::GetArraySize() {
+  if (fType == kInt) return fInts.size();
+  if (fType == kDouble) return fDoubles.size();
   const TString arraystring = GetStringValue(kTRUE);
   return GetArraySizeFromString(arraystring);
 }
 
 const char* CmdLineArg::GetStringValue(Bool_t arrayParsing) {
   if (fType == kStringNotChecked) {
-    const char* envVal = CmdLineConfig::instance()->GetEnv()->GetValue(
-        "CmdLine." + fName, (const char*)0);
+    const char* envVal =
+        CmdLineConfig::Current()->GetValue("CmdLine." + fName, (const char*)0);
     if (envVal != 0) {
       TString tmpString = envVal;
       fValue = tmpString.Strip();
@@ -189,50 +259,50 @@ const char* CmdLineArg::GetStringValue(Bool_t arrayParsing) {
 }
 
 const Bool_t CmdLineArg::GetFlagValue(const char* name) {
-  CmdLineArg* entry = CmdLineConfig::instance()->FindArgument(name);
+  CmdLineArg* entry = CmdLineConfig::Current()->FindArgument(name);
   if (entry) return entry->GetFlagValue();
   return kFALSE;
 }
 
 const Bool_t CmdLineArg::GetBoolValue(const char* name) {
-  CmdLineArg* entry = CmdLineConfig::instance()->FindArgument(name);
+  CmdLineArg* entry = CmdLineConfig::Current()->FindArgument(name);
   if (entry) return entry->GetBoolValue();
   return kFALSE;
 }
 
 const Int_t CmdLineArg::GetIntValue(const char* name) {
-  CmdLineArg* entry = CmdLineConfig::instance()->FindArgument(name);
+  CmdLineArg* entry = CmdLineConfig::Current()->FindArgument(name);
   if (entry) return entry->GetIntValue();
   return 0;
 }
 
 const Int_t CmdLineArg::GetIntArrayValue(const char* name, const Int_t index) {
-  CmdLineArg* entry = CmdLineConfig::instance()->FindArgument(name);
+  CmdLineArg* entry = CmdLineConfig::Current()->FindArgument(name);
   if (entry) return entry->GetIntArrayValue(index);
   return 0;
 }
 
 const Double_t CmdLineArg::GetDoubleValue(const char* name) {
-  CmdLineArg* entry = CmdLineConfig::instance()->FindArgument(name);
+  CmdLineArg* entry = CmdLineConfig::Current()->FindArgument(name);
   if (entry) return entry->GetDoubleValue();
   return 0.;
 }
 
 const Double_t CmdLineArg::GetDoubleArrayValue(const char* name,
                                                const Int_t index) {
-  CmdLineArg* entry = CmdLineConfig::instance()->FindArgument(name);
+  CmdLineArg* entry = CmdLineConfig::Current()->FindArgument(name);
   if (entry) return entry->GetDoubleArrayValue(index);
   return 0;
 }
 
 const Int_t CmdLineArg::GetArraySize(const char* name) {
-  CmdLineArg* entry = CmdLineConfig::instance()->FindArgument(name);
+  CmdLineArg* entry = CmdLineConfig::Current()->FindArgument(name);
   if (entry) return entry->GetArraySize();
   return 0;
 }
 
 const char* CmdLineArg::GetStringValue(const char* name) {
-  CmdLineArg* entry = CmdLineConfig::instance()->FindArgument(name);
+  CmdLineArg* entry = CmdLineConfig::Current()->FindArgument(name);
   if (entry) return entry->GetStringValue();
   return nullptr;
 }
@@ -305,39 +375,12 @@ void CmdLineArg::Print() {
 }
 
 const char* CmdLineArg::Getvalue(const char* name) const {
-  TEnvRec* tmp = CmdLineConfig::instance()->GetEnv()->Lookup(name);
+  TEnvRec* tmp = CmdLineConfig::Current()->Lookup(name);
   if (tmp != 0) return tmp->GetValue();
 
-  // ok, let's try to match wildcards: everything may be replaced by '*'
-  // except the first and last component
-
-  TString searchname = name;
-  TObjArray* components = searchname.Tokenize(".");
-  Int_t n = components->GetEntries();
-  Int_t max_count = 1 << (n - 1);
-  Int_t count = 2;
-  while (count < max_count) {
-    TString to_be_checked = "";
-    for (Int_t i = 0; i < n; i++) {
-      if (to_be_checked > "") to_be_checked += ".";
-      if (count & (1 << (n - i - 1))) {
-        to_be_checked += "*";
-      } else {
-        to_be_checked +=
-            dynamic_cast<TObjString*>(components->At(i))->GetString();
-      }
-    }
-    // std::cout << "Searching " << to_be_checked << std::endl;
-    tmp = CmdLineConfig::instance()->GetEnv()->Lookup(to_be_checked);
-    if (tmp) {
-      // std::cout << "Found." << std::endl;
-      delete components;
-      return tmp->GetValue();
-    }
-    count += 2;
-  }
-  delete components;
-  return nullptr;
+  // ok, let's try to match patterns, see CmdLineGlob
+  tmp = CmdLineConfig::Current()->LookupPattern(name);
+  return tmp ? tmp->GetValue() : nullptr;
 }
 
 // code taken from TEnv functions
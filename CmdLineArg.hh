@@ -35,8 +35,12 @@
 
 #include <vector>
 
+#include "CmdLineBinding.hh"
+
 class TList;
 class TEnv;
+class CmdLineConfig;
+class CmdLineRange;
 
 class CmdLineArg : public TObject {
 public:
@@ -61,6 +65,12 @@ public:
 
   const char* GetHelp() const;
 
+  /// Writes the value into the variable whenever the argument is set, see
+  /// CmdLineOption::Bind().
+  template <typename T> CmdLineBinding Bind(T& target) {
+    return AddBinding(CmdLineBinding::MakeWriter(target, this));
+  }
+
   const Bool_t GetFlagValue() const;
   const Bool_t GetBoolValue() const;
   const Int_t GetIntValue() const;
@@ -88,10 +98,15 @@ private:
   CmdLineArg(const CmdLineArg& ref); // LCOV_EXCL_LINE
 
   void Init(const char* name, const char* help, bool greedy = false);
+  CmdLineBinding AddBinding(const CmdLineBinding::Writer& writer);
+  Double_t GetBoundNumber();
+  const char* GetBoundText();
   Int_t GetValue(const char* name, Int_t def) const;
   Double_t GetValue(const char* name, Double_t def) const;
   const char* GetValue(const char* name, const char* def) const;
   const char* Getvalue(const char* name) const;
+  Bool_t SetValue(const char* value, const char* location = nullptr,
+                  CmdLineRange* range = nullptr);
 
   static const Int_t GetIntArrayValueFromString(const TString arraystring,
                                                 const Int_t index);
@@ -103,14 +118,22 @@ public:
   TString fName; // name used in .sorterrc
   TString fHelp; // help text
   TString fValue;
+  Int_t fInt;                     // value of bool and int arguments
+  Double_t fDouble;               // value of double arguments
+  std::vector<Int_t> fInts;       // all elements of int arrays
+  std::vector<Double_t> fDoubles; // all elements of double arrays
 
   OptionType fType;
 
   void (*fFunction)(); // function to be called when changed
 
+  CmdLineConfig* fConfig; // context the object is registered in
+  const CmdLineArg* fDefinition; //! argument this one was copied from
+
   static const TString delim;
 
   friend class CmdLineConfig;
+  friend class CmdLineBinding;
 
   ClassDef(CmdLineArg, 0); // LCOV_EXCL_LINE
 };
@@ -0,0 +1,149 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineBatch.cc
+  \brief
+
+  <long description>
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <atomic>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+
+#include "CmdLineBatch.hh"
+#include "CmdLineConfig.hh"
+
+CmdLineBatch::CmdLineBatch(CmdLineConfig* parent)
+    : fParent(parent ? parent : CmdLineConfig::instance()), fProgName("job") {}
+
+CmdLineBatch::~CmdLineBatch() {}
+
+Int_t CmdLineBatch::ReadJobList(const char* filename) {
+  std::ifstream in(filename);
+  if (!in) {
+    std::cerr << "CmdLineBatch: job list not readable (" << filename << ")"
+              << std::endl;
+    return -1;
+  }
+
+  Int_t n = 0;
+  std::string line;
+  while (std::getline(in, line)) {
+    size_t first = line.find_first_not_of(" \t\r");
+    if (first == std::string::npos || line[first] == '#') continue;
+    AddJob(line.c_str());
+    ++n;
+  }
+  return n;
+}
+
+void CmdLineBatch::AddJob(const char* line) {
+  fJobs.push_back(SplitArgs(line));
+}
+
+std::vector<TString> CmdLineBatch::SplitArgs(const char* line) {
+  std::vector<TString> args;
+  TString current;
+  Bool_t inToken = kFALSE;
+  char quote = 0;
+
+  for (const char* cp = line; *cp; ++cp) {
+    char c = *cp;
+    if (quote) {
+      if (c == quote)
+        quote = 0;
+      else if (c == '\\' && quote == '"' && cp[1])
+        current += *++cp;
+      else
+        current += c;
+    } else if (c == '"' || c == '\'') {
+      quote = c;
+      inToken = kTRUE;
+    } else if (c == '\\' && cp[1]) {
+      current += *++cp;
+      inToken = kTRUE;
+    } else if (isspace((int)c)) {
+      if (inToken) args.push_back(current);
+      current = "";
+      inToken = kFALSE;
+    } else {
+      current += c;
+      inToken = kTRUE;
+    }
+  }
+  if (quote)
+    std::cerr << "CmdLineBatch: unterminated quote in '" << line << "'"
+              << std::endl;
+  if (inToken) args.push_back(current);
+
+  return args;
+}
+
+void CmdLineBatch::ParallelFor(size_t n, UInt_t nthreads,
+                               const std::function<void(size_t)>& fn) {
+  if (nthreads == 0) nthreads = std::thread::hardware_concurrency();
+  if (nthreads == 0) nthreads = 1;
+  if (nthreads > n) nthreads = n;
+
+  std::atomic<size_t> next(0);
+  auto worker = [&] {
+    size_t i;
+    while ((i = next++) < n)
+      fn(i);
+  };
+
+  if (nthreads <= 1) {
+    worker();
+    return;
+  }
+
+  std::vector<std::thread> pool;
+  for (UInt_t t = 0; t < nthreads; ++t)
+    pool.push_back(std::thread(worker));
+  for (UInt_t t = 0; t < nthreads; ++t)
+    pool[t].join();
+}
+
+Int_t CmdLineBatch::Run(const BatchCallback& callback, UInt_t nthreads) {
+  // rc files are read once, all jobs share them
+  fParent->GetEnv();
+
+  std::atomic<Int_t> failed(0);
+  ParallelFor(fJobs.size(), nthreads, [&](size_t job) {
+    const std::vector<TString>& args = fJobs[job];
+    std::vector<char*> argv;
+    argv.push_back((char*)fProgName.Data());
+    for (size_t i = 0; i < args.size(); ++i)
+      argv.push_back((char*)args[i].Data());
+
+    CmdLineConfig view(fParent);
+    if (!view.ReadJobLine(argv.size(), argv.data())) {
+      std::cerr << "CmdLineBatch: job " << job << " skipped" << std::endl;
+      ++failed;
+      return;
+    }
+
+    CmdLineConfig::Scope scope(&view);
+    callback(view, job);
+  });
+  return failed;
+}
@@ -0,0 +1,66 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineBatch.hh
+  \brief  Runs many command lines in one process
+
+  Each job of the batch is a single command line. The rc files and the
+  registered options of the parent context are loaded once, every job is
+  parsed into its own child context and handed over to a user callback
+  running on a pool of threads.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINEBATCH_HH
+#define _CMDLINEBATCH_HH
+
+#include <functional>
+#include <vector>
+
+#include <TString.h>
+
+class CmdLineConfig;
+
+typedef std::function<void(CmdLineConfig& view, size_t job)> BatchCallback;
+
+class CmdLineBatch {
+public:
+  CmdLineBatch(CmdLineConfig* parent = nullptr);
+  virtual ~CmdLineBatch();
+
+  Int_t ReadJobList(const char* filename);
+  void AddJob(const char* line);
+  size_t GetNJobs() const { return fJobs.size(); }
+  const std::vector<TString>& GetJob(size_t job) const { return fJobs[job]; }
+
+  void SetProgramName(const char* name) { fProgName = name; }
+  /// Jobs which cannot be parsed are reported and skipped. Returns their
+  /// number.
+  Int_t Run(const BatchCallback& callback, UInt_t nthreads = 0);
+
+  static std::vector<TString> SplitArgs(const char* line);
+  static void ParallelFor(size_t n, UInt_t nthreads,
+                          const std::function<void(size_t)>& fn);
+
+private:
+  CmdLineConfig* fParent;
+  TString fProgName;
+  std::vector<std::vector<TString>> fJobs;
+};
+
+#endif
@@ -0,0 +1,162 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineBinding.cc
+  \brief
+
+  The bindings of all contexts are kept in one registry ordered by source.
+  Writers are called with the registry locked, so that a binding released
+  by another thread is never written after Release() returned.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <iterator>
+#include <map>
+#include <mutex>
+
+#include "CmdLineBinding.hh"
+#include "CmdLineConfig.hh"
+
+struct BoundVariable {
+  UInt_t fId;
+  CmdLineConfig* fConfig; // context the values are taken from
+  CmdLineBinding::Writer fWriter;
+};
+
+typedef std::multimap<const TObject*, BoundVariable> Bindings;
+
+// never destroyed, handles may be released at exit
+static std::recursive_mutex& gBindingsMutex = *new std::recursive_mutex;
+static Bindings& gBindings = *new Bindings;
+static UInt_t gNextId = 1;
+static std::atomic<size_t> gNBindings(0);
+
+// Tells whether the values of the context are seen by the other.
+static Bool_t IsBelow(const CmdLineConfig* other, const CmdLineConfig* config) {
+  for (; other; other = other->GetParent())
+    if (other == config) return kTRUE;
+  return kFALSE;
+}
+
+CmdLineBinding::CmdLineBinding(CmdLineBinding&& other)
+    : fSource(other.fSource), fId(other.fId) {
+  other.fId = 0;
+}
+
+CmdLineBinding& CmdLineBinding::operator=(CmdLineBinding&& other) {
+  if (this != &other) {
+    Release();
+    fSource = other.fSource;
+    fId = other.fId;
+    other.fId = 0;
+  }
+  return *this;
+}
+
+CmdLineBinding::~CmdLineBinding() { Release(); }
+
+void CmdLineBinding::Release() {
+  if (!fId) return;
+
+  std::lock_guard<std::recursive_mutex> lock(gBindingsMutex);
+  std::pair<Bindings::iterator, Bindings::iterator> range =
+      gBindings.equal_range(fSource);
+  for (Bindings::iterator it = range.first; it != range.second; ++it)
+    if (it->second.fId == fId) {
+      gBindings.erase(it);
+      --gNBindings;
+      break;
+    }
+  fId = 0;
+}
+
+Bool_t CmdLineBinding::IsBound() const {
+  if (!fId) return kFALSE;
+
+  std::lock_guard<std::recursive_mutex> lock(gBindingsMutex);
+  std::pair<Bindings::iterator, Bindings::iterator> range =
+      gBindings.equal_range(fSource);
+  for (Bindings::iterator it = range.first; it != range.second; ++it)
+    if (it->second.fId == fId) return kTRUE;
+  return kFALSE;
+}
+
+CmdLineBinding CmdLineBinding::Add(CmdLineConfig* config,
+                                   const TObject* source,
+                                   const Writer& writer) {
+  std::lock_guard<std::recursive_mutex> lock(gBindingsMutex);
+  BoundVariable binding = {gNextId++, config, writer};
+  gBindings.insert(std::make_pair(source, binding));
+  ++gNBindings;
+
+  CmdLineConfig::Scope scope(config);
+  writer();
+  return CmdLineBinding(source, binding.fId);
+}
+
+void CmdLineBinding::Write(CmdLineConfig* config, const TObject* source) {
+  if (IsEmpty()) return;
+
+  std::lock_guard<std::recursive_mutex> lock(gBindingsMutex);
+  std::pair<Bindings::iterator, Bindings::iterator> range =
+      gBindings.equal_range(source);
+  for (Bindings::iterator it = range.first; it != range.second; ++it) {
+    // other contexts, e.g. jobs of a batch, run in other threads
+    if (config && !IsBelow(it->second.fConfig, config)) continue;
+    CmdLineConfig::Scope scope(it->second.fConfig);
+    it->second.fWriter();
+  }
+}
+
+void CmdLineBinding::WriteAll(CmdLineConfig* config) {
+  if (IsEmpty()) return;
+
+  std::lock_guard<std::recursive_mutex> lock(gBindingsMutex);
+  for (Bindings::iterator it = gBindings.begin(); it != gBindings.end(); ++it) {
+    if (!IsBelow(it->second.fConfig, config)) continue;
+    CmdLineConfig::Scope scope(it->second.fConfig);
+    it->second.fWriter();
+  }
+}
+
+Bool_t CmdLineBinding::IsEmpty() { return gNBindings == 0; }
+
+void CmdLineBinding::Remove(const TObject* source) {
+  if (IsEmpty()) return;
+
+  std::lock_guard<std::recursive_mutex> lock(gBindingsMutex);
+  std::pair<Bindings::iterator, Bindings::iterator> range =
+      gBindings.equal_range(source);
+  gNBindings -= std::distance(range.first, range.second);
+  gBindings.erase(range.first, range.second);
+}
+
+void CmdLineBinding::Remove(CmdLineConfig* config) {
+  if (IsEmpty()) return;
+
+  std::lock_guard<std::recursive_mutex> lock(gBindingsMutex);
+  Bindings::iterator it = gBindings.begin();
+  while (it != gBindings.end()) {
+    if (it->second.fConfig != config) {
+      ++it;
+      continue;
+    }
+    it = gBindings.erase(it);
+    --gNBindings;
+  }
+}
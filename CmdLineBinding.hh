@@ -0,0 +1,102 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineBinding.hh
+  \brief  Variables the values of options and arguments are written into
+
+  A binding made by CmdLineOption::Bind() or CmdLineArg::Bind() writes the
+  value into a user variable whenever it changes, so that the variable can
+  be read in loops without calling the library. The binding lasts until
+  the handle, the option or the context is destroyed.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINEBINDING_HH
+#define _CMDLINEBINDING_HH
+
+#include <atomic>
+#include <functional>
+#include <type_traits>
+
+#include <TObject.h>
+
+class CmdLineConfig;
+
+// a handle which is not kept ends the binding at once
+class [[nodiscard]] CmdLineBinding {
+public:
+  typedef std::function<void()> Writer;
+
+  CmdLineBinding() : fSource(nullptr), fId(0) {}
+  CmdLineBinding(CmdLineBinding&& other);
+  CmdLineBinding& operator=(CmdLineBinding&& other);
+  virtual ~CmdLineBinding();
+
+  /// Ends the binding, the variable keeps the last value written.
+  void Release();
+  Bool_t IsBound() const;
+
+  /// Function writing the value of the option or argument into the
+  /// variable: a number, TString or std::string, plain or atomic.
+  template <typename T, typename S>
+  static Writer MakeWriter(T& target, S* source) {
+    return [&target, source] { Store(target, source); };
+  }
+
+private:
+  friend class CmdLineConfig;
+  friend class CmdLineOption;
+  friend class CmdLineArg;
+
+  CmdLineBinding(const TObject* source, UInt_t id)
+      : fSource(source), fId(id) {}
+  CmdLineBinding(const CmdLineBinding&) = delete;
+  CmdLineBinding& operator=(const CmdLineBinding&) = delete;
+
+  template <typename T, typename S> static T Load(S* source) {
+    if constexpr (std::is_arithmetic<T>::value)
+      return (T)source->GetBoundNumber();
+    else
+      return T(source->GetBoundText());
+  }
+  template <typename T, typename S> static void Store(T& target, S* source) {
+    target = Load<T>(source);
+  }
+  template <typename T, typename S>
+  static void Store(std::atomic<T>& target, S* source) {
+    target.store(Load<T>(source));
+  }
+
+  /// Registers the writer for the context and calls it once.
+  static CmdLineBinding Add(CmdLineConfig* config, const TObject* source,
+                            const Writer& writer);
+  /// Calls the writers of the source bound in the context or in contexts
+  /// below it, which see its values; in any context if nullptr.
+  static void Write(CmdLineConfig* config, const TObject* source);
+  /// Calls all writers bound in the context or in contexts below it.
+  static void WriteAll(CmdLineConfig* config);
+  static Bool_t IsEmpty();
+  /// Drops the bindings of a destroyed source or context.
+  static void Remove(const TObject* source);
+  static void Remove(CmdLineConfig* config);
+
+  const TObject* fSource;
+  UInt_t fId; // 0 if not bound
+};
+
+#endif
@@ -33,32 +33,110 @@
 #include <TObjString.h>
 #include <TString.h>
 
+#include <algorithm>
+#include <atomic>
+#include <charconv>
 #include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <mutex>
+#include <set>
+#include <thread>
 
 #include "CmdLineConfig.hh"
-
-TEnv* CmdLineConfig::fgEnv = nullptr;
-CmdLineConfig::Options CmdLineConfig::fgOpts;
-Positional CmdLineConfig::fgArgs;
-Greedy CmdLineConfig::fgGreedy;
-TString CmdLineConfig::fPosText = "[...]";
-Int_t CmdLineConfig::fGreedyPosition = -1;
-CmdLineArg* CmdLineConfig::fGreedy = nullptr;
-
-CmdLineConfig::ListMap CmdLineConfig::_map_opts;
-CmdLineConfig::ListMap CmdLineConfig::_map_args;
+#include "CmdLineRcFile.hh"
+#include "CmdLineResolver.hh"
+#include "CmdLineShm.hh"
+
+// Context used by the static members in the calling thread, nullptr selects
+// the default one.
+static thread_local CmdLineConfig* gCurrent = nullptr;
+
+// Serializes loading of a shared parent environment by child contexts.
+static std::recursive_mutex gLoadMutex;
+
+// Shared memory segment used instead of the rc files, see SetSharedEnv().
+static TString gShmName;
+
+// Default context reads the rc files in the background, see SetAsyncLoad().
+static Bool_t gAsyncLoad = kFALSE;
+
+// Options the rc files to read depend on.
+static const char* gLoadOptions[] = {"DefaultPath", "IncludePath", "Include",
+                                     nullptr};
+
+// Replacements of layers a retired layer outlives, see Retire().
+static const ULong64_t gRetiredUpdates = 2;
+
+// Last generation given to any context, generations of a context and its
+// parents are thus comparable.
+static std::atomic<ULong64_t> gGeneration(0);
+
+// Value of a key in the given layers, from the top, then in the parent.
+static CmdLineRcFile::Lower Below(const std::vector<TEnv*>& layers,
+                                  CmdLineConfig* parent) {
+  return [layers, parent](const char* key) -> const char* {
+    TEnvRec* rec = nullptr;
+    for (size_t l = 0; l < layers.size() && !rec; ++l)
+      rec = layers[l]->Lookup(key);
+    if (!rec && parent) rec = parent->Lookup(key);
+    return rec ? rec->GetValue() : nullptr;
+  };
+}
 
 static CmdLineOption t6("ParameterDirectory", "", "", "./");
 
 static CmdLineOption datadir("DataDir", "-dd", "Set path to data directory",
                              "./share");
 
-CmdLineConfig::CmdLineConfig() : name(".cmdlinerc"){};
+CmdLineConfig::CmdLineConfig() : CmdLineConfig(".cmdlinerc"){};
+
+CmdLineConfig::CmdLineConfig(const char* name)
+    : fParent(nullptr), fShm(nullptr), fUpdates(0), fAsync(nullptr),
+      name(name),
+      fGreedy(nullptr),
+      fGreedyPosition(-1), fPosText("[...]"),
+      fNextHandlerId(0), fStamp(++gGeneration), fOptionsStamp(0),
+      fJournalSize(1024),
+      fJournalLost(0), fModifiedAll(0), fResolvedGeneration(0),
+      fGlobGeneration(0),
+      fOptionTreeGeneration(0), fKeyTreeGeneration(0), fRouteArena(4096),
+      fRoutesGeneration(0) {
+  for (Int_t l = 0; l < kNLayers; ++l)
+    fLayers[l] = nullptr;
+  // defaults are known before anything is read
+  fLayers[kLayerDefaults] = new TEnv("");
+}
 
-CmdLineConfig::CmdLineConfig(const char* name) : name(name){};
+CmdLineConfig::CmdLineConfig(CmdLineConfig* parent, const char* name)
+    : CmdLineConfig(name ? name : parent->name.Data()) {
+  fParent = parent;
+  fPosText = parent->fPosText;
 
-CmdLineConfig::~CmdLineConfig(){};
+  std::lock_guard<std::recursive_mutex> lock(gLoadMutex);
+  parent->GetEnv();
+}
+
+CmdLineConfig::~CmdLineConfig() {
+  FinishLoading(kFALSE);
+  CmdLineBinding::Remove(this);
+  Scope scope(this);
+  DestroyExpanded();
+  ClearGreedy();
+  for (size_t i = 0; i < fOwnedArgs.size(); ++i)
+    delete fOwnedArgs[i];
+  for (size_t i = 0; i < fOwnedOpts.size(); ++i)
+    delete fOwnedOpts[i];
+  for (Int_t l = 0; l < kNLayers; ++l)
+    delete fLayers[l];
+  for (size_t i = 0; i < fOverrides.size(); ++i)
+    delete fOverrides[i];
+  for (size_t i = 0; i < fRetired.size(); ++i)
+    delete fRetired[i].fEnv;
+  delete fShm;
+};
 
 CmdLineConfig* CmdLineConfig::inst = nullptr;
 
@@ -68,76 +146,548 @@ CmdLineConfig* CmdLineConfig::instance(const char* name) {
       inst = new CmdLineConfig(name);
     else
       inst = new CmdLineConfig();
+    if (gAsyncLoad) inst->LoadAsync();
   }
 
   return inst;
 }
 
+CmdLineConfig* CmdLineConfig::Current() {
+  if (gCurrent) return gCurrent;
+  return instance();
+}
+
+CmdLineConfig::Scope::Scope(CmdLineConfig* config) : fPrevious(gCurrent) {
+  gCurrent = config;
+}
+
+CmdLineConfig::Scope::~Scope() { gCurrent = fPrevious; }
+
+void CmdLineConfig::InheritArguments() {
+  if (!fParent || fArgs.size() || fGreedyPosition >= 0) return;
+
+  CmdLineConfig* source = fParent;
+  while (source->fArgs.empty() && source->fGreedyPosition < 0 &&
+         source->fParent)
+    source = source->fParent;
+
+  // definitions are copied so that every context keeps its own values
+  Scope scope(this);
+  Int_t pos = 0;
+  ListMap::const_iterator ait = source->_map_args.begin();
+  while (ait != source->_map_args.end()) {
+    if (pos++ == source->fGreedyPosition) fGreedyPosition = fArgs.size();
+    CmdLineArg* def = source->fArgs[*ait++];
+    CmdLineArg* arg = new CmdLineArg(def->fName, def->fHelp, def->fType);
+    arg->fDefinition = def->fDefinition ? def->fDefinition : def;
+    fOwnedArgs.push_back(arg);
+  }
+  if (pos == source->fGreedyPosition) fGreedyPosition = fArgs.size();
+  fGreedy = source->fGreedy;
+}
+
+CmdLineConfig* CmdLineConfig::ArgumentsContext() {
+  // contexts which did not read a command line show those of the parent
+  CmdLineConfig* cfg = this;
+  while (cfg->fArgs.empty() && cfg->fGreedyPosition < 0 &&
+         cfg->fGreedyArgs.empty() && cfg->fParent)
+    cfg = cfg->fParent;
+  return cfg;
+}
+
 void CmdLineConfig::ReadCmdLine(int argc, char** argv) {
+  ParseCmdLine(argc, argv, kFALSE);
+}
+
+Bool_t CmdLineConfig::ReadJobLine(int argc, char** argv) {
+  for (Int_t i = 1; i < argc; i++) {
+    TString arg = argv[i];
+    if (arg == "-h" || arg == "-p" || arg == "-extra-sorterrc") {
+      std::cerr << "CmdLineConfig: " << arg << " not allowed here"
+                << std::endl;
+      return kFALSE;
+    }
+  }
+  return ParseCmdLine(argc, argv, kTRUE);
+}
+
+Bool_t CmdLineConfig::ParseCmdLine(int argc, char** argv, Bool_t job) {
+  Scope scope(this);
   GetEnv();
 
-  fgGreedy.erase(fgGreedy.begin(), fgGreedy.end());
-  fgGreedy.clear();
+  // the subcommand is not an argument, the rest is parsed without it
+  std::vector<char*> subargv;
+  Int_t sub = SelectSubcommand(argc, argv, job);
+  if (sub == 0) return kFALSE;
+  if (sub > 0) {
+    subargv.assign(argv, argv + argc);
+    subargv.erase(subargv.begin() + sub);
+    argc = subargv.size();
+    argv = subargv.data();
+  }
+
+  InheritArguments();
+  NewGeneration();
+
+  ClearGreedy();
 
   std::vector<TString> positional;
+  std::vector<Int_t> positionalIndex;
 
   for (Int_t i = 1; i < argc; i++) {
     Bool_t isCmdLine = kFALSE;
     if (CheckCmdLineSpecial(argc, argv, i)) continue;
 
-    Options::const_iterator it = fgOpts.begin();
-
-    while (it != fgOpts.end()) {
-      CmdLineOption* entry = (it++)->second;
-      if (entry->fCmdArg == "") continue;
-
-      if (entry->fCmdArg == argv[i]) {
-        isCmdLine = kTRUE;
-        if (entry->fType == CmdLineOption::kFlag)
-          CmdLineConfig::instance()->GetEnv()->SetValue(
-              "CmdLine." + entry->fName, kTRUE);
-        else if (i < argc - 1)
-          CmdLineConfig::instance()->GetEnv()->SetValue(
-              "CmdLine." + entry->fName, argv[++i]);
-        if (entry->fFunction != 0) (*entry->fFunction)();
-        break;
+    for (CmdLineConfig* cfg = this; cfg && !isCmdLine; cfg = cfg->fParent) {
+      Options::const_iterator it = cfg->fOpts.begin();
+
+      while (it != cfg->fOpts.end()) {
+        CmdLineOption* entry = (it++)->second;
+        if (entry->fCmdArg == "") continue;
+
+        if (entry->fCmdArg == argv[i]) {
+          isCmdLine = kTRUE;
+          if (entry->fType == CmdLineOption::kFlag)
+            SetLayerValue(kLayerCmdLine, "CmdLine." + entry->fName, "1");
+          else if (i < argc - 1)
+            SetLayerValue(kLayerCmdLine, "CmdLine." + entry->fName, argv[++i]);
+          Validate(entry, TString::Format("argument %d", i));
+          MarkChanged(entry);
+          break;
+        }
       }
     }
 
-    if (!isCmdLine) positional.push_back(argv[i]);
+    if (!isCmdLine) {
+      positional.push_back(argv[i]);
+      positionalIndex.push_back(i);
+    }
   }
 
-  int greedy_len = positional.size() - fgArgs.size();
+  int greedy_len = positional.size() - fArgs.size();
   if (greedy_len < 0) {
-    std::cerr << "Not enough positional arguments. Needed " << fgArgs.size()
+    std::cerr << "Not enough positional arguments. Needed " << fArgs.size()
               << ", given " << positional.size() << std::endl;
+    if (job) return kFALSE;
     abort();
   }
 
-  Positional::iterator pit = fgArgs.begin();
   Int_t greedy_end = fGreedyPosition + greedy_len - 1;
 
   ListMap::iterator ait = _map_args.begin();
 
   for (int i = 0; i < positional.size(); ++i) {
+    TString location = TString::Format("argument %d", positionalIndex[i]);
     if (i < fGreedyPosition) {
-      fgArgs[*ait++]->fValue = positional[i];
+      fArgs[*ait++]->SetValue(positional[i], location);
     } else if (i > greedy_end) {
-      fgArgs[*ait++]->fValue = positional[i];
+      fArgs[*ait++]->SetValue(positional[i], location);
     } else {
-      CmdLineArg* greedy =
-          new CmdLineArg("", "", fGreedy->fType, nullptr, true);
-      greedy->fValue = positional[i];
-      fgGreedy.push_back(greedy);
+      AddGreedy(fGreedy->fType, positional[i], location);
     }
   }
+  fGreedyRange.BuildIndex();
+
+  DispatchChanges();
+  return kTRUE;
 }
 
-ParameterSource CmdLineConfig::GetParameterSource() {
-  if (nullptr == inst) instance();
+Int_t CmdLineConfig::AddCallback(const ChangeCallback& callback,
+                                 const ChangedOptions& options) {
+  ChangeHandler handler;
+  handler.fId = fNextHandlerId++;
+  handler.fCallback = callback;
+  handler.fOptions = options;
+  fHandlers.push_back(handler);
+  return handler.fId;
+}
 
-  TString mode = inst->GetEnv()->GetValue("CmdLine.ParameterSource",
-                                          "sql" /*CConstBase::ParSource()*/);
+void CmdLineConfig::RemoveCallback(Int_t id) {
+  for (size_t i = 0; i < fHandlers.size(); ++i) {
+    if (fHandlers[i].fId == id) {
+      fHandlers.erase(fHandlers.begin() + i);
+      return;
+    }
+  }
+}
+
+void CmdLineConfig::AddSubcommand(const char* name, const char* help,
+                                  const SubcommandFactory& factory) {
+  for (size_t i = 0; i < fSubcommands.size(); ++i) {
+    if (fSubcommands[i].fName == name) {
+      std::cerr << "CmdLineConfig: subcommand '" << name
+                << "' already exists -> fix it" << std::endl;
+      exit(1);
+    }
+  }
+
+  Subcommand cmd;
+  cmd.fName = name;
+  cmd.fHelp = help;
+  cmd.fFactory = factory;
+  fSubcommands.push_back(cmd);
+}
+
+Int_t CmdLineConfig::SelectSubcommand(int argc, char** argv, Bool_t job) {
+  const Subcommand* known = nullptr;
+  for (CmdLineConfig* cfg = this; cfg && !known; cfg = cfg->fParent)
+    if (cfg->fSubcommands.size()) known = cfg->fSubcommands.data();
+  if (!known) return -1;
+
+  // the first argument which is neither an option nor its value
+  Int_t pos = -1;
+  for (Int_t i = 1; i < argc && pos < 0; i++) {
+    TString arg = argv[i];
+    if (arg == "-h" || arg == "-p") continue;
+    if (arg == "-extra-sorterrc") {
+      ++i;
+      continue;
+    }
+
+    CmdLineOption* entry = nullptr;
+    for (CmdLineConfig* cfg = this; cfg && !entry; cfg = cfg->fParent) {
+      Options::const_iterator it = cfg->fOpts.begin();
+      while (it != cfg->fOpts.end() && !entry) {
+        CmdLineOption* opt = (it++)->second;
+        if (opt->fCmdArg != "" && opt->fCmdArg == arg) entry = opt;
+      }
+    }
+    if (!entry) pos = i;
+    else if (entry->fType != CmdLineOption::kFlag) ++i;
+  }
+  if (pos < 0) return -1;
+
+  const Subcommand* cmd = nullptr;
+  for (CmdLineConfig* cfg = this; cfg && !cmd; cfg = cfg->fParent)
+    for (size_t i = 0; i < cfg->fSubcommands.size() && !cmd; ++i)
+      if (cfg->fSubcommands[i].fName == argv[pos]) cmd = &cfg->fSubcommands[i];
+
+  if (!cmd) {
+    std::cerr << "CmdLineConfig: unknown subcommand '" << argv[pos] << "'"
+              << std::endl;
+    if (job) return 0;
+    exit(1);
+  }
+
+  if (fSubcommand == cmd->fName) return pos;
+  if (!fSubcommand.IsNull()) {
+    std::cerr << "CmdLineConfig: subcommand '" << fSubcommand
+              << "' already selected" << std::endl;
+    if (job) return 0;
+    exit(1);
+  }
+
+  fSubcommand = cmd->fName;
+  cmd->fFactory(*this);
+  return pos;
+}
+
+void CmdLineConfig::ClearGreedy() {
+  // greedy arguments of a previous command line are replaced, not appended
+  for (size_t i = 0; i < fGreedyArgs.size(); ++i)
+    delete fGreedyArgs[i];
+  fGreedyArgs.clear();
+  fGreedyInts.clear();
+  fGreedyRange.Clear();
+  fGreedyDoubles.clear();
+}
+
+void CmdLineConfig::AddGreedy(CmdLineArg::OptionType type, const char* value,
+                              const char* location) {
+  CmdLineArg* greedy = new CmdLineArg("", "", type, nullptr, true);
+  greedy->SetValue(value, location, &fGreedyRange);
+  fGreedyArgs.push_back(greedy);
+
+  // contiguous copies for bulk processing, int ranges are expanded on demand
+  fGreedyInts.insert(fGreedyInts.end(), greedy->fInts.begin(),
+                     greedy->fInts.end());
+  fGreedyDoubles.insert(fGreedyDoubles.end(), greedy->fDoubles.begin(),
+                        greedy->fDoubles.end());
+}
+
+const std::vector<Int_t>& CmdLineConfig::GetGreedyIntArguments() {
+  CmdLineConfig* cfg = Current()->ArgumentsContext();
+  std::lock_guard<std::mutex> lock(cfg->fValuesMutex);
+  if (cfg->fGreedyInts.size() < cfg->fGreedyRange.size())
+    cfg->fGreedyInts.assign(cfg->fGreedyRange.begin(),
+                            cfg->fGreedyRange.end());
+  return cfg->fGreedyInts;
+}
+
+void CmdLineConfig::MarkChanged(CmdLineOption* opt) {
+  Journal("CmdLine." + opt->fName);
+  for (size_t i = 0; i < fChanged.size(); ++i)
+    if (fChanged[i] == opt) return;
+  fChanged.push_back(opt);
+}
+
+void CmdLineConfig::DispatchChanges() {
+  if (fChanged.empty()) return;
+
+  // callbacks may change the configuration again, start a new batch
+  ChangedOptions changed;
+  changed.swap(fChanged);
+
+  Scope scope(this);
+
+  // bound variables hold the new values before any callback runs
+  for (size_t i = 0; i < changed.size(); ++i)
+    CmdLineBinding::Write(this, changed[i]);
+
+  // functions shared by several options are called only once
+  std::vector<void (*)()> functions;
+  for (size_t i = 0; i < changed.size(); ++i) {
+    void (*f)() = changed[i]->fFunction;
+    if (!f) continue;
+    Bool_t seen = kFALSE;
+    for (size_t j = 0; j < functions.size() && !seen; ++j)
+      seen = functions[j] == f;
+    if (!seen) functions.push_back(f);
+  }
+  for (size_t i = 0; i < functions.size(); ++i)
+    (*functions[i])();
+
+  std::vector<ChangeHandler> handlers = fHandlers;
+  for (size_t h = 0; h < handlers.size(); ++h) {
+    const ChangedOptions& watched = handlers[h].fOptions;
+    if (watched.empty()) {
+      handlers[h].fCallback(changed);
+      continue;
+    }
+
+    ChangedOptions selected;
+    for (size_t i = 0; i < changed.size(); ++i)
+      for (size_t j = 0; j < watched.size(); ++j)
+        if (changed[i] == watched[j]) selected.push_back(changed[i]);
+    if (selected.size()) handlers[h].fCallback(selected);
+  }
+}
+
+void CmdLineConfig::ReadExtraFile(const char* filename) {
+  // resolved values before and after reading tell which options changed
+  ChangedOptions options;
+  std::vector<TString> before;
+  for (CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent) {
+    Options::const_iterator it = cfg->fOpts.begin();
+    while (it != cfg->fOpts.end()) {
+      CmdLineOption* entry = (it++)->second;
+      options.push_back(entry);
+      before.push_back(entry->Getvalue("CmdLine." + entry->fName));
+    }
+  }
+
+  GetEnv();
+  CmdLineRcFile::ReadFile(
+      fLayers[kLayerExtra], filename, kEnvChange,
+      Below({fLayers[kLayerUser], fLayers[kLayerGlobal]}, fParent));
+  fRcFiles.push_back(filename);
+  fExtraFiles.push_back(filename);
+  // keys of the file are not known, all are taken as changed
+  NewGeneration();
+  JournalAll();
+
+  for (size_t i = 0; i < options.size(); ++i) {
+    const char* cp = options[i]->Getvalue("CmdLine." + options[i]->fName);
+    if (cp && before[i] != cp) {
+      Validate(options[i], nullptr);
+      MarkChanged(options[i]);
+    }
+  }
+}
+
+ULong64_t CmdLineConfig::GetGeneration() const {
+  ULong64_t generation = 0;
+  for (const CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent)
+    generation = std::max(generation, cfg->fStamp);
+  return generation;
+}
+
+void CmdLineConfig::Invalidate() {
+  // the layers may have been modified directly
+  for (Int_t t = 0; t < 2; ++t) {
+    Layer layer = t ? kLayerRuntime : kLayerCmdLine;
+    fTables.Clear(t);
+    if (!fLayers[layer]) continue;
+    TIter it(fLayers[layer]->GetTable());
+    TEnvRec* rec;
+    while ((rec = dynamic_cast<TEnvRec*>(it.Next())))
+      fTables.Set(t, rec->GetName(), rec->GetValue());
+  }
+
+  NewGeneration();
+  JournalAll();
+}
+
+ULong64_t CmdLineConfig::GetOptionsGeneration() const {
+  ULong64_t generation = 0;
+  for (const CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent)
+    generation = std::max(generation, cfg->fOptionsStamp);
+  return generation;
+}
+
+ULong64_t CmdLineConfig::GetModified(const char* key) const {
+  ULong64_t generation = 0;
+  for (const CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent) {
+    generation = std::max(generation, cfg->fModifiedAll);
+    std::map<TString, ULong64_t>::const_iterator it = cfg->fModified.find(key);
+    if (it != cfg->fModified.end())
+      generation = std::max(generation, it->second);
+  }
+  return generation;
+}
+
+ULong64_t CmdLineConfig::GetModified(const CmdLineOption* opt) const {
+  return GetModified("CmdLine." + opt->fName);
+}
+
+Bool_t CmdLineConfig::GetChanges(ULong64_t since,
+                                 std::vector<TString>& keys) const {
+  Bool_t complete = kTRUE;
+  for (const CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent) {
+    if (since < cfg->fJournalLost) complete = kFALSE;
+    // newest entries are at the back
+    std::deque<JournalEntry>::const_reverse_iterator it =
+        cfg->fJournal.rbegin();
+    for (; it != cfg->fJournal.rend() && it->fGeneration > since; ++it)
+      keys.push_back(it->fKey);
+  }
+  return complete;
+}
+
+void CmdLineConfig::SetJournalSize(size_t size) {
+  fJournalSize = size;
+  while (fJournal.size() > fJournalSize) {
+    fJournalLost = fJournal.front().fGeneration;
+    fJournal.pop_front();
+  }
+}
+
+void CmdLineConfig::NewGeneration() { fStamp = ++gGeneration; }
+
+void CmdLineConfig::Journal(const char* key) {
+  ULong64_t& modified = fModified[key];
+  if (modified == fStamp) return;
+  modified = fStamp;
+
+  fJournal.push_back({fStamp, key});
+  if (fJournal.size() > fJournalSize) SetJournalSize(fJournalSize);
+}
+
+void CmdLineConfig::JournalAll() {
+  fJournal.clear();
+  fModified.clear();
+  fJournalLost = fModifiedAll = fStamp;
+}
+
+const CmdLineValue& CmdLineConfig::GetTypedValue(const CmdLineOption* opt) {
+  // rc files must be read before the state is known
+  for (CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent)
+    cfg->GetEnv();
+
+  ULong64_t stamp = GetGeneration();
+  std::lock_guard<std::mutex> lock(fValuesMutex);
+  // new entries have no stamp, they are converted at the first read
+  CmdLineValue& value = fValues[opt];
+  if (value.fStamp && value.fStamp != stamp && !IsChanged(opt, value.fStamp))
+    value.fStamp = stamp;
+  if (value.fStamp != stamp) {
+    Scope scope(this);
+    TEnvRec* rec = opt->Findvalue("CmdLine." + opt->fName);
+    // options expanded after the rc files were read are checked here
+    Report(opt, opt->Convert(rec ? rec->GetValue() : nullptr, value), rec,
+           nullptr);
+    value.fStamp = stamp;
+  }
+  return value;
+}
+
+Bool_t CmdLineConfig::IsChanged(const CmdLineOption* opt,
+                                 ULong64_t since) const {
+  std::vector<TString> keys;
+  if (!GetChanges(since, keys)) return kTRUE;
+  // a changed pattern may match the option
+  TString key = "CmdLine." + opt->fName;
+  for (size_t i = 0; i < keys.size(); ++i)
+    if (keys[i] == key || CmdLineGlob::IsPattern(keys[i])) return kTRUE;
+  return kFALSE;
+}
+
+Bool_t CmdLineConfig::Validate(const CmdLineOption* opt, const char* location) {
+  switch (opt->fType) {
+    case CmdLineOption::kFlag:
+    case CmdLineOption::kBool:
+    case CmdLineOption::kInt:
+    case CmdLineOption::kDouble:
+      break;
+    default:
+      return kTRUE;
+  }
+
+  Scope scope(this);
+  TEnvRec* rec = opt->Findvalue("CmdLine." + opt->fName);
+  CmdLineValue value;
+  Bool_t ok = opt->Convert(rec ? rec->GetValue() : nullptr, value);
+  value.fStamp = GetGeneration();
+  std::lock_guard<std::mutex> lock(fValuesMutex);
+  fValues[opt] = value;
+  Report(opt, ok, rec, location);
+  return ok;
+}
+
+void CmdLineConfig::Report(const CmdLineOption* opt, Bool_t ok, TEnvRec* rec,
+                           const char* location) {
+  // Called with fValuesMutex held. A malformed value of the configuration is
+  // reported once, until the key gets another value; values given at a
+  // location, like the command line, are reported each time.
+  TString key = "CmdLine." + opt->fName;
+  if (ok || !rec) {
+    fReported.erase(key);
+    return;
+  }
+  std::map<TString, TString>::iterator it = fReported.find(key);
+  if (!location && it != fReported.end() && it->second == rec->GetValue())
+    return;
+  fReported[key] = rec->GetValue();
+
+  TString where = location ? TString(location) : FindSource(rec->GetName());
+  std::cerr << "CmdLineOption: invalid value '" << rec->GetValue() << "' of "
+            << opt->fName << " at " << where << ", using default" << std::endl;
+  if (CmdLineOption::AbortOnWarning) abort();
+}
+
+void CmdLineConfig::ValidateAll() {
+  for (CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent) {
+    Options::const_iterator it = cfg->fOpts.begin();
+    while (it != cfg->fOpts.end())
+      Validate((it++)->second, nullptr);
+  }
+}
+
+TString CmdLineConfig::FindSource(const char* key) const {
+  // the last definition of the key is the one in effect
+  TString prefix = key;
+  for (const CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent) {
+    for (size_t f = cfg->fRcFiles.size(); f-- > 0;) {
+      std::ifstream in(cfg->fRcFiles[f].Data());
+      std::string line;
+      Int_t n = 0, found = 0;
+      while (std::getline(in, line)) {
+        ++n;
+        TString entry = TString(line.c_str()).Strip(TString::kLeading);
+        if (!entry.BeginsWith(prefix)) continue;
+        entry.Remove(0, prefix.Length());
+        if (entry.Strip(TString::kLeading).BeginsWith(":")) found = n;
+      }
+      if (found)
+        return TString::Format("%s:%d", cfg->fRcFiles[f].Data(), found);
+    }
+  }
+  return "configuration";
+}
+
+ParameterSource CmdLineConfig::GetParameterSource() {
+  TString mode = Current()->GetValue("CmdLine.ParameterSource",
+                                     "sql" /*CConstBase::ParSource()*/);
   if (mode == "sql")
     return kSql;
   else if (mode == "file")
@@ -153,37 +703,24 @@ ParameterSource CmdLineConfig::GetParameterSource() {
 }
 
 ParameterSource CmdLineConfig::GetParameterSourceType(const char* name) {
-  if (nullptr == inst) instance();
-
-  TString query = "CmdLine.ParSource.";
-  query += name;
-
-  TString mode = inst->GetEnv()->GetValue(
-      query, inst->GetEnv()->GetValue("CmdLine.ParameterSource",
-                                      "sql" /*CConstBase::ParSource()*/));
-  if (gDebug)
+  CmdLineConfig* cfg = Current();
+  if (gDebug) {
+    TString query = "CmdLine.ParSource.";
+    query += name;
     std::cout << "CmdLineConfig: Query for parameter source type'" << query
               << "'\n"
-              << "              returned '" << mode << "'" << std::endl;
-
-  if (mode == "sql")
-    return kSql;
-  else if (mode == "file")
-    return kFile;
-  else if (mode == "fileimport")
-    return kFileImport;
-  else {
-    return kImportExport;
+              << "              returned '"
+              << cfg->GetValue(query, cfg->GetValue("CmdLine.ParameterSource",
+                                                    "sql"))
+              << "'" << std::endl;
   }
+  return cfg->Route(kFALSE, name);
 }
 
 const TString CmdLineConfig::GetParameterSource(const char* name) {
-  if (nullptr == inst) instance();
-
   TString query = "CmdLine.ParSource.";
   query += name;
-  const char* res =
-      inst->GetEnv()->GetValue(query, static_cast<const char*>(0));
+  const char* res = Current()->GetValue(query, static_cast<const char*>(0));
   if (gDebug)
     std::cout << "CmdLineConfig: Query for parameter source '" << query << "'\n"
               << "              returned '" << res << "'" << std::endl;
@@ -191,18 +728,14 @@ const TString CmdLineConfig::GetParameterSource(const char* name) {
 }
 
 void CmdLineConfig::SetParameterSource(const char* name, const char* source) {
-  if (nullptr == inst) instance();
-
   TString query = "CmdLine.ParSource.";
   query += name;
-  inst->GetEnv()->SetValue(query, source);
+  Current()->SetValue(query, source);
 }
 
 ParameterSource CmdLineConfig::GetParameterDrain() {
-  if (nullptr == inst) instance();
-
-  TString mode = inst->GetEnv()->GetValue("CmdLine.ParameterDrain",
-                                          "file" /*CConstBase::ParDrain()*/);
+  TString mode = Current()->GetValue("CmdLine.ParameterDrain",
+                                     "file" /*CConstBase::ParDrain()*/);
   if (mode == "sql")
     return kSql;
   else if (mode == "file")
@@ -216,35 +749,90 @@ ParameterSource CmdLineConfig::GetParameterDrain() {
 }
 
 ParameterSource CmdLineConfig::GetParameterDrainType(const char* name) {
-  if (nullptr == inst) instance();
-
-  TString query = "CmdLine.ParDrain.";
-  query += name;
-
-  TString mode = inst->GetEnv()->GetValue(
-      query, inst->GetEnv()->GetValue("CmdLine.ParameterDrain",
-                                      "file" /*CConstBase::ParDrain()*/));
-  if (gDebug)
+  CmdLineConfig* cfg = Current();
+  if (gDebug) {
+    TString query = "CmdLine.ParDrain.";
+    query += name;
     std::cout << "CmdLineConfig: Query for parameter drain type'" << query
               << "'\n"
-              << "              returned '" << mode << "'" << std::endl;
+              << "              returned '"
+              << cfg->GetValue(query, cfg->GetValue("CmdLine.ParameterDrain",
+                                                    "file"))
+              << "'" << std::endl;
+  }
+  return cfg->Route(kTRUE, name);
+}
 
-  if (mode == "sql")
-    return kSql;
-  else if (mode == "file")
-    return kFile;
-  else {
-    return kImportExport;
+// Keys of the routes of parameter sources and drains.
+static const char* gRoutePrefix[2] = {"CmdLine.ParSource.",
+                                      "CmdLine.ParDrain."};
+static const char* gRouteDefault[2] = {"CmdLine.ParameterSource",
+                                       "CmdLine.ParameterDrain"};
+
+static ParameterSource RouteType(Bool_t drain, const char* mode) {
+  if (!strcmp(mode, "sql")) return kSql;
+  if (!strcmp(mode, "file")) return kFile;
+  if (!drain && !strcmp(mode, "fileimport")) return kFileImport;
+  return kImportExport;
+}
+
+ParameterSource CmdLineConfig::Route(Bool_t drain, const char* name) {
+  GetEnv();
+
+  std::lock_guard<std::mutex> lock(fRoutesMutex);
+  // the table is built again only after keys of routes changed
+  ULong64_t generation = GetGeneration();
+  if (generation != fRoutesGeneration) {
+    std::vector<TString> keys;
+    Bool_t build = !fRoutesGeneration || !GetChanges(fRoutesGeneration, keys);
+    for (size_t i = 0; i < keys.size() && !build; ++i)
+      for (Int_t t = 0; t < 2 && !build; ++t)
+        build = keys[i].BeginsWith(gRoutePrefix[t]) ||
+                keys[i] == gRouteDefault[t];
+    if (build) BuildRoutes();
+    fRoutesGeneration = generation;
   }
-};
 
-const TString CmdLineConfig::GetParameterDrain(const char* name) {
-  if (nullptr == inst) instance();
+  Routes::const_iterator it = fRoutes[drain].find(name);
+  return it != fRoutes[drain].end() ? it->second : fDefaultRoute[drain];
+}
 
+void CmdLineConfig::BuildRoutes() {
+  fRouteArena.Clear();
+  for (Int_t t = 0; t < 2; ++t) {
+    fRoutes[t].clear();
+    fDefaultRoute[t] =
+        RouteType(t, GetValue(gRouteDefault[t], t ? "file" : "sql"));
+  }
+
+  // keys of all layers, resolved like by GetValue()
+  for (CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent) {
+    cfg->GetEnv();
+    std::vector<TEnv*> layers(cfg->fLayers + kLayerGlobal,
+                              cfg->fLayers + kNLayers);
+    layers.insert(layers.end(), cfg->fOverrides.begin(),
+                  cfg->fOverrides.end());
+    for (size_t l = 0; l < layers.size(); ++l) {
+      TIter it(layers[l]->GetTable());
+      TEnvRec* rec;
+      while ((rec = dynamic_cast<TEnvRec*>(it.Next()))) {
+        for (Int_t t = 0; t < 2; ++t) {
+          size_t length = strlen(gRoutePrefix[t]);
+          if (strncmp(rec->GetName(), gRoutePrefix[t], length)) continue;
+          const char* name = rec->GetName() + length;
+          if (fRoutes[t].count(name)) continue;
+          const char* mode = GetValue(rec->GetName(), "");
+          fRoutes[t][fRouteArena.Copy(name)] = RouteType(t, mode);
+        }
+      }
+    }
+  }
+}
+
+const TString CmdLineConfig::GetParameterDrain(const char* name) {
   TString query = "CmdLine.ParDrain.";
   query += name;
-  const char* res =
-      inst->GetEnv()->GetValue(query, static_cast<const char*>(0));
+  const char* res = Current()->GetValue(query, static_cast<const char*>(0));
   if (gDebug)
     std::cout << "CmdLineConfig: Query for parameter source '" << query << "'\n"
               << "              returned '" << res << "'" << std::endl;
@@ -252,28 +840,30 @@ const TString CmdLineConfig::GetParameterDrain(const char* name) {
 };
 
 void CmdLineConfig::SetParameterDrain(const char* name, const char* drain) {
-  if (nullptr == inst) instance();
-
   TString query = "CmdLine.ParDrain.";
   query += name;
-  inst->GetEnv()->SetValue(query, drain);
+  Current()->SetValue(query, drain);
 }
 
 const TString CmdLineConfig::GetResource(const char* path, const char* file,
                                          EAccessMode mode) {
-  char* resource = gSystem->Which(path, file, mode);
-  if (!resource) { return ""; }
-  return resource;
+  return CmdLineResolver::instance()->Resolve(path, file, mode);
 }
 
-TEnv* CmdLineConfig::GetEnv() {
-  if (fgEnv != 0) return fgEnv;
+const TString CmdLineConfig::GetDataResource(const char* file,
+                                             EAccessMode mode) {
+  return GetResource(CmdLineOption::GetStringValue("DataDir"), file, mode);
+}
 
-  fgEnv = new TEnv(name.Data());
+// Reads the rc files found through the values of gLoadOptions, in order.
+static void ReadRcFiles(const TString& name, TEnv* global, TEnv* user,
+                        std::vector<TString>& files,
+                        const std::function<const char*(const char*)>& value) {
+  // the user layer continues values appended to the global one
+  CmdLineRcFile::Lower lower = Below({global}, nullptr);
   TString defaultpath = "";
-  if (CmdLineOption::GetStringValue("DefaultPath")) {
-    defaultpath =
-        gSystem->ExpandPathName(CmdLineOption::GetStringValue("DefaultPath"));
+  if (value("DefaultPath")) {
+    defaultpath = gSystem->ExpandPathName(value("DefaultPath"));
     if (gSystem->AccessPathName(defaultpath)) {
       std::cerr << "Error: default path not accessible (" << defaultpath << ")"
                 << std::endl;
@@ -289,7 +879,8 @@ TEnv* CmdLineConfig::GetEnv() {
         while ((localname = gSystem->GetDirEntry(dirp))) {
           TString strName = localname;
           if (strName.EndsWith(".rc")) {
-            fgEnv->ReadFile(defaultpath + strName, kEnvGlobal);
+            CmdLineRcFile::ReadFile(global, defaultpath + strName, kEnvGlobal);
+            files.push_back(defaultpath + strName);
           }
         }
         gSystem->FreeDirectory(dirp);
@@ -297,14 +888,12 @@ TEnv* CmdLineConfig::GetEnv() {
     }
   }
   TString includepath = "";
-  if (CmdLineOption::GetStringValue("IncludePath")) {
-    includepath =
-        gSystem->ExpandPathName(CmdLineOption::GetStringValue("IncludePath"));
+  if (value("IncludePath")) {
+    includepath = gSystem->ExpandPathName(value("IncludePath"));
     if (!(includepath.EndsWith("/"))) includepath += "/";
   }
-  if (CmdLineOption::GetStringValue("Include")) {
-    TString includes =
-        gSystem->ExpandPathName(CmdLineOption::GetStringValue("Include"));
+  if (value("Include")) {
+    TString includes = gSystem->ExpandPathName(value("Include"));
     TObjArray* includesArray = includes.Tokenize(" ");
     TObjString* objString;
     TIter it(includesArray);
@@ -320,7 +909,8 @@ TEnv* CmdLineConfig::GetEnv() {
         void* dirp = gSystem->OpenDirectory(filename);
         if (dirp == 0) {
           std::cout << "Reading " << filename << std::endl;
-          fgEnv->ReadFile(filename, kEnvUser);
+          CmdLineRcFile::ReadFile(user, filename, kEnvUser, lower);
+          files.push_back(filename);
         } else {
           if (!filename.EndsWith("/")) filename += "/";
           const char* localname = 0;
@@ -328,7 +918,9 @@ TEnv* CmdLineConfig::GetEnv() {
             TString strName = localname;
             if (strName.EndsWith(".rc")) {
               std::cout << "Reading " << filename + strName << std::endl;
-              fgEnv->ReadFile(filename + strName, kEnvUser);
+              CmdLineRcFile::ReadFile(user, filename + strName, kEnvUser,
+                                      lower);
+              files.push_back(filename + strName);
             }
           }
           gSystem->FreeDirectory(dirp);
@@ -340,10 +932,858 @@ TEnv* CmdLineConfig::GetEnv() {
   // work-around because values in these files are overwritten by
   // values in "Defaults" directory
   char* s = gSystem->ConcatFileName(gSystem->HomeDirectory(), name.Data());
-  fgEnv->ReadFile(s, kEnvChange);
+  CmdLineRcFile::ReadFile(user, s, kEnvChange, lower);
+  files.push_back(s);
   delete[] s;
-  fgEnv->ReadFile(name.Data(), kEnvChange);
-  return fgEnv;
+  CmdLineRcFile::ReadFile(user, name.Data(), kEnvChange, lower);
+  files.push_back(name);
+}
+
+// Rc files read into layers of their own, in a background thread or aside of
+// the layers in use.
+struct CmdLineConfig::RcLoad {
+  struct Value {
+    TString fKey;
+    TString fValue;
+    Bool_t fFound;
+  };
+
+  std::thread fThread;
+  TEnv* fGlobal;
+  TEnv* fUser;
+  std::vector<TString> fFiles;
+  std::map<TString, TString> fDefaults; // of the options defined at the start
+  std::vector<Value> fValues;           // the files were found with
+  Bool_t fApplying;
+
+  RcLoad() : fGlobal(nullptr), fUser(nullptr), fApplying(kFALSE) {}
+  ~RcLoad() {
+    delete fGlobal;
+    delete fUser;
+  }
+
+  void Read(const TString& name) {
+    fGlobal = new TEnv(name.Data());
+    fUser = new TEnv("");
+    ReadRcFiles(name, fGlobal, fUser, fFiles,
+                [this](const char* key) { return GetValue(key); });
+  }
+
+  // value of the option as seen by the synchronous reading, without access
+  // to the context
+  const char* GetValue(const char* key) {
+    const char* value = nullptr;
+    std::map<TString, TString>::const_iterator it = fDefaults.find(key);
+    if (it != fDefaults.end()) {
+      TString name = TString("CmdLine.") + key;
+      TEnvRec* rec = fUser->Lookup(name);
+      if (!rec) rec = fGlobal->Lookup(name);
+      value = rec ? rec->GetValue() : it->second.Data();
+    }
+    Value used = {key, value ? value : "", value != nullptr};
+    fValues.push_back(used);
+    return value;
+  }
+};
+
+TEnv* CmdLineConfig::GetEnv() {
+  // rc files read in the background are taken over at the first access
+  if (fAsync) FinishLoading(kTRUE);
+  if (fLayers[kLayerRuntime]) return fLayers[kLayerRuntime];
+
+  // layers exist before reading, values are looked up during that
+  for (Int_t l = 0; l < kNLayers; ++l)
+    if (!fLayers[l]) fLayers[l] = new TEnv("");
+
+  // child contexts see the rc files through their parent
+  if (fParent) return fLayers[kLayerRuntime];
+
+  // the configuration may be read already by the server of the node
+  TString shm = gShmName;
+  if (shm.IsNull() && getenv("CMDLINE_SHM")) shm = getenv("CMDLINE_SHM");
+  if (!shm.IsNull() && AttachSharedEnv(shm)) return fLayers[kLayerRuntime];
+
+  delete fLayers[kLayerGlobal];
+  fLayers[kLayerGlobal] = new TEnv(name.Data());
+  TEnv* global = fLayers[kLayerGlobal];
+  TEnv* user = fLayers[kLayerUser];
+  ReadRcFiles(name, global, user, fRcFiles, [](const char* key) {
+    return CmdLineOption::GetStringValue(key);
+  });
+
+  // malformed values are reported once, when the files are read
+  NewGeneration();
+  JournalAll();
+  ValidateAll();
+  return fLayers[kLayerRuntime];
+}
+
+void CmdLineConfig::LoadAsync() {
+  std::lock_guard<std::recursive_mutex> lock(gLoadMutex);
+  // child contexts read no files, a shared segment is attached at once
+  if (fParent || fAsync || fLayers[kLayerRuntime]) return;
+  if (!gShmName.IsNull() || getenv("CMDLINE_SHM")) return;
+
+  RcLoad* load = NewLoad();
+  TString rcname = name;
+  load->fThread = std::thread([load, rcname]() { load->Read(rcname); });
+  fAsync = load;
+}
+
+CmdLineConfig::RcLoad* CmdLineConfig::NewLoad() {
+  RcLoad* load = new RcLoad;
+  Scope scope(this);
+  for (const char** key = gLoadOptions; *key; ++key) {
+    if (!FindOption(*key)) continue;
+    TEnvRec* rec = LookupDefault(TString("CmdLine.") + *key);
+    load->fDefaults[*key] = rec ? rec->GetValue() : "";
+  }
+  return load;
+}
+
+void CmdLineConfig::FinishLoading(Bool_t apply) {
+  std::lock_guard<std::recursive_mutex> lock(gLoadMutex);
+  RcLoad* load = fAsync;
+  // values are looked up while the records are taken over
+  if (!load || load->fApplying) return;
+  load->fThread.join();
+
+  if (apply) {
+    load->fApplying = kTRUE;
+    for (Int_t l = 0; l < kNLayers; ++l)
+      if (!fLayers[l]) fLayers[l] = new TEnv("");
+    std::swap(fLayers[kLayerGlobal], load->fGlobal);
+    std::swap(fLayers[kLayerUser], load->fUser);
+    fRcFiles.swap(load->fFiles);
+    NewGeneration();
+    JournalAll();
+
+    // options defined or set after the start may select other files
+    Scope scope(this);
+    Bool_t stale = kFALSE;
+    for (size_t i = 0; i < load->fValues.size() && !stale; ++i) {
+      const char* value =
+          CmdLineOption::GetStringValue(load->fValues[i].fKey);
+      stale = (value != nullptr) != load->fValues[i].fFound ||
+              (value && load->fValues[i].fValue != value);
+    }
+    if (stale) {
+      // read again by GetEnv()
+      for (Int_t l = kLayerGlobal; l < kNLayers; ++l) {
+        delete fLayers[l];
+        fLayers[l] = nullptr;
+      }
+      fTables.Clear(0);
+      fTables.Clear(1);
+      fRcFiles.clear();
+    } else {
+      ValidateAll();
+    }
+  }
+
+  fAsync = nullptr;
+  delete load;
+}
+
+void CmdLineConfig::Reload() {
+  std::lock_guard<std::recursive_mutex> lock(gLoadMutex);
+  FinishLoading(kFALSE);
+  for (Int_t l = kLayerGlobal; l < kNLayers; ++l) {
+    delete fLayers[l];
+    fLayers[l] = nullptr;
+  }
+  fTables.Clear(0);
+  fTables.Clear(1);
+  delete fShm;
+  fShm = nullptr;
+  fRcFiles.clear();
+  fExtraFiles.clear();
+  NewGeneration();
+  JournalAll();
+  GetEnv();
+  CmdLineBinding::WriteAll(this);
+}
+
+// Adds the keys of the records differing between the layers.
+static void DiffLayers(TEnv* a, TEnv* b, std::set<TString>& keys) {
+  TIter it(a->GetTable());
+  TEnvRec* rec;
+  while ((rec = dynamic_cast<TEnvRec*>(it.Next()))) {
+    TEnvRec* other = b->Lookup(rec->GetName());
+    if (!other || strcmp(rec->GetValue(), other->GetValue()))
+      keys.insert(rec->GetName());
+  }
+  TIter added(b->GetTable());
+  while ((rec = dynamic_cast<TEnvRec*>(added.Next())))
+    if (!a->Lookup(rec->GetName())) keys.insert(rec->GetName());
+}
+
+// Sets a value by replacing its record, the old record is moved to the
+// retired layer because other threads may still read it.
+static void ReplaceValue(TEnv* env, TEnv* retired, const char* name,
+                         const char* value) {
+  const char* key = *name == '+' ? name + 1 : name;
+  TEnvRec* old = env->Lookup(key);
+  TEnv scratch("");
+  if (old) scratch.SetValue(key, old->GetValue(), old->GetLevel(),
+                            old->GetType());
+  scratch.SetValue(name, value);
+  TEnvRec* rec = scratch.Lookup(key);
+  scratch.GetTable()->Remove(rec);
+  if (old) retired->GetTable()->Add(env->GetTable()->Remove(old));
+  env->GetTable()->Add(rec);
+}
+
+Int_t CmdLineConfig::Update(const KeyValues& values, Bool_t files) {
+  std::lock_guard<std::recursive_mutex> load(gLoadMutex);
+  GetEnv();
+  Scope scope(this);
+
+  // the files are read aside, lookups still see the old records meanwhile
+  TEnv* fresh[kNLayers] = {nullptr};
+  std::vector<TString> rcfiles;
+  Bool_t read = files && !fParent && !fShm;
+  if (read) {
+    RcLoad* load = NewLoad();
+    load->Read(name);
+    std::swap(fresh[kLayerGlobal], load->fGlobal);
+    std::swap(fresh[kLayerUser], load->fUser);
+    rcfiles.swap(load->fFiles);
+    delete load;
+    fresh[kLayerExtra] = new TEnv("");
+    CmdLineRcFile::Lower lower =
+        Below({fresh[kLayerUser], fresh[kLayerGlobal]}, fParent);
+    for (size_t i = 0; i < fExtraFiles.size(); ++i) {
+      CmdLineRcFile::ReadFile(fresh[kLayerExtra], fExtraFiles[i], kEnvChange,
+                              lower);
+      rcfiles.push_back(fExtraFiles[i]);
+    }
+  }
+
+  std::set<TString> keys;
+  for (Int_t l = 0; l < kNLayers; ++l)
+    if (fresh[l]) DiffLayers(fLayers[l], fresh[l], keys);
+  TEnv* target = fOverrides.size() ? fOverrides.back() : fLayers[kLayerRuntime];
+  std::vector<size_t> set;
+  for (size_t i = 0; i < values.size(); ++i) {
+    // appended values always change
+    const char* name = values[i].first;
+    TEnvRec* rec = *name == '+' ? nullptr : target->Lookup(name);
+    if (rec && values[i].second == rec->GetValue()) continue;
+    keys.insert(*name == '+' ? name + 1 : name);
+    set.push_back(i);
+  }
+
+  // options matched by changed patterns are compared, the others are known
+  Bool_t patterns = kFALSE;
+  std::set<TString>::const_iterator key;
+  for (key = keys.begin(); key != keys.end() && !patterns; ++key)
+    patterns = CmdLineGlob::IsPattern(*key);
+  ChangedOptions options;
+  std::vector<TString> before;
+  for (CmdLineConfig* cfg = this; cfg && patterns; cfg = cfg->fParent) {
+    Options::const_iterator it = cfg->fOpts.begin();
+    while (it != cfg->fOpts.end()) {
+      CmdLineOption* entry = (it++)->second;
+      options.push_back(entry);
+      before.push_back(entry->Getvalue("CmdLine." + entry->fName));
+    }
+  }
+
+  TEnv* replaced = new TEnv("");
+  {
+    // in the order of LookupPattern()
+    std::lock_guard<std::mutex> glob(fGlobMutex);
+    std::lock_guard<std::mutex> resolved(fResolvedMutex);
+    for (Int_t l = 0; l < kNLayers; ++l)
+      if (fresh[l]) std::swap(fLayers[l], fresh[l]);
+    for (size_t i = 0; i < set.size(); ++i) {
+      const KeyValues::value_type& value = values[set[i]];
+      ReplaceValue(target, replaced, value.first, value.second);
+      if (!fOverrides.size()) Track(kLayerRuntime, value.first);
+    }
+    NewGeneration();
+    for (key = keys.begin(); key != keys.end(); ++key)
+      Journal(*key);
+    // the old layers are retired below, their keys are resolved again even
+    // if unchanged, here and in the child contexts
+    for (Int_t l = 0; l < kNLayers; ++l) {
+      if (!fresh[l]) continue;
+      TEnv* layers[2] = {fLayers[l], fresh[l]};
+      for (Int_t i = 0; i < 2; ++i) {
+        TIter it(layers[i]->GetTable());
+        TEnvRec* rec;
+        while ((rec = dynamic_cast<TEnvRec*>(it.Next())))
+          Journal(rec->GetName());
+      }
+    }
+  }
+  // records handed out before may still be read in other threads
+  ReleaseRetired();
+  for (Int_t l = 0; l < kNLayers; ++l)
+    if (fresh[l]) Retire(fresh[l]);
+  if (replaced->GetTable()->GetSize())
+    Retire(replaced);
+  else
+    delete replaced;
+  if (read) fRcFiles.swap(rcfiles);
+
+  for (key = keys.begin(); key != keys.end(); ++key)
+    KeyChanged(*key);
+  for (size_t i = 0; i < options.size(); ++i) {
+    const char* cp = options[i]->Getvalue("CmdLine." + options[i]->fName);
+    if (before[i] != (cp ? cp : "")) MarkChanged(options[i]);
+  }
+  for (size_t i = 0; i < fChanged.size(); ++i)
+    Validate(fChanged[i], nullptr);
+  DispatchChanges();
+  return keys.size();
+}
+
+void CmdLineConfig::SetSharedEnv(const char* name) { gShmName = name; }
+
+void CmdLineConfig::SetAsyncLoad(Bool_t async) {
+  gAsyncLoad = async;
+  if (async && inst) inst->LoadAsync();
+}
+
+Bool_t CmdLineConfig::AttachSharedEnv(const char* name) {
+  CmdLineShm* shm = new CmdLineShm(name);
+  if (!shm->Attach()) {
+    std::cerr << "CmdLineConfig: shared configuration " << shm->GetName()
+              << " not available" << std::endl;
+    delete shm;
+    return kFALSE;
+  }
+
+  // the segment replaces the rc files only, values set later are kept
+  GetEnv();
+  TEnv* global = new TEnv("");
+  TEnv* user = new TEnv("");
+  shm->Fill(user);
+  {
+    // in the order of LookupPattern()
+    std::lock_guard<std::mutex> glob(fGlobMutex);
+    std::lock_guard<std::mutex> resolved(fResolvedMutex);
+    std::swap(fLayers[kLayerGlobal], global);
+    std::swap(fLayers[kLayerUser], user);
+    NewGeneration();
+    JournalAll();
+  }
+  ReleaseRetired();
+  Retire(global);
+  Retire(user);
+  delete fShm;
+  fShm = shm;
+  fRcFiles.clear();
+
+  ValidateAll();
+  return kTRUE;
+}
+
+Bool_t CmdLineConfig::SyncSharedEnv() {
+  std::lock_guard<std::recursive_mutex> load(gLoadMutex);
+  if (!fShm || !fShm->IsStale()) return kFALSE;
+
+  // resolved values before and after tell which options changed
+  Scope scope(this);
+  ChangedOptions options;
+  std::vector<TString> before;
+  for (CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent) {
+    Options::const_iterator it = cfg->fOpts.begin();
+    while (it != cfg->fOpts.end()) {
+      CmdLineOption* entry = (it++)->second;
+      options.push_back(entry);
+      before.push_back(entry->Getvalue("CmdLine." + entry->fName));
+    }
+  }
+
+  // the old records stay in use if the new segment cannot be attached
+  TString segment = fShm->GetName();
+  if (!AttachSharedEnv(segment)) return kFALSE;
+
+  for (size_t i = 0; i < options.size(); ++i) {
+    const char* cp = options[i]->Getvalue("CmdLine." + options[i]->fName);
+    if (before[i] != (cp ? cp : "")) MarkChanged(options[i]);
+  }
+  DispatchChanges();
+  return kTRUE;
+}
+
+void CmdLineConfig::Retire(TEnv* env) {
+  // records handed out by Lookup() may still be read in other threads, so
+  // a replaced layer is deleted only after further replacements
+  fRetired.push_back({fUpdates, env});
+}
+
+void CmdLineConfig::ReleaseRetired() {
+  // called before layers are replaced again
+  ++fUpdates;
+  size_t n = 0;
+  while (n < fRetired.size() &&
+         fRetired[n].fUpdate + gRetiredUpdates < fUpdates)
+    delete fRetired[n++].fEnv;
+  fRetired.erase(fRetired.begin(), fRetired.begin() + n);
+}
+
+TEnvRec* CmdLineConfig::Lookup(const char* name) {
+  GetEnv();
+
+  std::lock_guard<std::mutex> lock(fResolvedMutex);
+  // only the keys changed since the last lookup are resolved again
+  ULong64_t generation = GetGeneration();
+  if (generation != fResolvedGeneration) {
+    std::vector<TString> keys;
+    if (GetChanges(fResolvedGeneration, keys)) {
+      for (size_t i = 0; i < keys.size(); ++i)
+        fResolved.erase(keys[i].Data());
+    } else {
+      fResolved.clear();
+    }
+    fResolvedGeneration = generation;
+  }
+
+  Resolved::const_iterator it = fResolved.find(name);
+  if (it != fResolved.end()) return it->second;
+
+  TEnvRec* rec = nullptr;
+  for (size_t i = fOverrides.size(); i-- > 0 && !rec;)
+    rec = fOverrides[i]->Lookup(name);
+  for (Int_t l = kNLayers; l-- > kLayerGlobal && !rec;)
+    rec = fLayers[l]->Lookup(name);
+  if (!rec && fParent) rec = fParent->Lookup(name);
+
+  fResolved[name] = rec;
+  return rec;
+}
+
+TEnvRec* CmdLineConfig::LookupPattern(const char* name) {
+  GetEnv();
+
+  std::lock_guard<std::mutex> lock(fGlobMutex);
+  // changed values of patterns are found by Lookup(), only changed keys
+  // which are patterns need compiling again
+  ULong64_t generation = GetGeneration();
+  if (generation != fGlobGeneration) {
+    std::vector<TString> keys;
+    Bool_t compile = !fGlobGeneration || !GetChanges(fGlobGeneration, keys);
+    for (size_t i = 0; i < keys.size() && !compile; ++i)
+      compile = CmdLineGlob::IsPattern(keys[i]);
+    if (compile) CompilePatterns();
+    fGlobGeneration = generation;
+  }
+
+  const char* pattern = fGlob.Match(name);
+  return pattern ? Lookup(pattern) : nullptr;
+}
+
+void CmdLineConfig::CompilePatterns() {
+  // in the order of Lookup(), which decides between equal patterns
+  std::vector<TString> patterns;
+  std::set<TString> seen;
+  for (CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent) {
+    cfg->GetEnv();
+    std::vector<TEnv*> layers(cfg->fLayers + kLayerGlobal,
+                              cfg->fLayers + kNLayers);
+    layers.insert(layers.end(), cfg->fOverrides.begin(),
+                  cfg->fOverrides.end());
+    for (size_t l = layers.size(); l-- > 0;) {
+      TIter it(layers[l]->GetTable());
+      TEnvRec* rec;
+      while ((rec = dynamic_cast<TEnvRec*>(it.Next()))) {
+        if (!CmdLineGlob::IsPattern(rec->GetName())) continue;
+        if (seen.insert(rec->GetName()).second)
+          patterns.push_back(rec->GetName());
+      }
+    }
+  }
+  fGlob.Compile(patterns);
+}
+
+TEnvRec* CmdLineConfig::LookupDefault(const char* name) {
+  if (strncmp(name, "CmdLine.", 8) != 0) return nullptr;
+
+  for (CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent) {
+    Options::const_iterator it = cfg->fOpts.find(name + 8);
+    if (it == cfg->fOpts.end()) continue;
+
+    // records are made when a default is needed for the first time
+    std::lock_guard<std::mutex> lock(cfg->fResolvedMutex);
+    TEnvRec* rec = cfg->fLayers[kLayerDefaults]->Lookup(name);
+    if (!rec) rec = cfg->InsertDefault(it->second);
+    return rec;
+  }
+  return nullptr;
+}
+
+const char* CmdLineConfig::GetValue(const char* name, const char* dflt) {
+  TEnvRec* rec = Lookup(name);
+  if (rec) return rec->GetValue();
+  return dflt;
+}
+
+void CmdLineConfig::SetValue(const char* name, const char* value) {
+  GetEnv();
+  if (fOverrides.size()) {
+    fOverrides.back()->SetValue(name, value);
+  } else {
+    fLayers[kLayerRuntime]->SetValue(name, value);
+    Track(kLayerRuntime, name);
+  }
+  NewGeneration();
+  Journal(name);
+  WriteBindings(name);
+}
+
+void CmdLineConfig::WriteBindings(const char* name) {
+  if (CmdLineBinding::IsEmpty() || strncmp(name, "CmdLine.", 8)) return;
+  if (CmdLineGlob::IsPattern(name)) {
+    CmdLineBinding::WriteAll(this);
+    return;
+  }
+  for (CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent) {
+    Options::const_iterator it = cfg->fOpts.find(name + 8);
+    if (it != cfg->fOpts.end()) {
+      CmdLineBinding::Write(this, it->second);
+      return;
+    }
+  }
+}
+
+void CmdLineConfig::Track(Layer layer, const char* name) {
+  // values of the layers in snapshots
+  Int_t table = -1;
+  if (layer == kLayerCmdLine) table = 0;
+  if (layer == kLayerRuntime) table = 1;
+  if (table < 0) return;
+
+  if (*name == '+') ++name;
+  TEnvRec* rec = fLayers[layer]->Lookup(name);
+  if (rec)
+    fTables.Set(table, name, rec->GetValue());
+  else
+    fTables.Erase(table, name);
+}
+
+const CmdLineTree& CmdLineConfig::GetOptionTree() {
+  GetEnv();
+  std::lock_guard<std::mutex> lock(fTreeMutex);
+  // inserted options are no change of values, but are part of the tree
+  ULong64_t generation = std::max(GetGeneration(), GetOptionsGeneration());
+  if (fOptionTreeGeneration == generation) return fOptionTree;
+
+  Scope scope(this);
+  fOptionTree.Clear();
+  for (CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent) {
+    Options::const_iterator it = cfg->fOpts.begin();
+    for (; it != cfg->fOpts.end(); ++it) {
+      // options of the context hide those of the parents
+      Bool_t hidden = kFALSE;
+      for (CmdLineConfig* c = this; c != cfg && !hidden; c = c->fParent)
+        hidden = c->fOpts.count(it->first) > 0;
+      if (hidden) continue;
+      CmdLineOption* opt = it->second;
+      fOptionTree.Add(opt->fName, opt->GetStringValue(kTRUE), opt);
+    }
+  }
+  fOptionTree.Build();
+  fOptionTreeGeneration = generation;
+  return fOptionTree;
+}
+
+const CmdLineTree& CmdLineConfig::GetKeyTree() {
+  GetEnv();
+  std::lock_guard<std::mutex> lock(fTreeMutex);
+  ULong64_t generation = GetGeneration();
+  if (fKeyTreeGeneration == generation) return fKeyTree;
+
+  // parents first, so that the records of this context take precedence
+  std::vector<CmdLineConfig*> chain;
+  for (CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent)
+    chain.insert(chain.begin(), cfg);
+
+  std::map<std::string_view, const char*> values;
+  for (size_t c = 0; c < chain.size(); ++c) {
+    CmdLineConfig* cfg = chain[c];
+    cfg->GetEnv();
+    std::vector<TEnv*> layers(cfg->fLayers + kLayerGlobal,
+                              cfg->fLayers + kNLayers);
+    layers.insert(layers.end(), cfg->fOverrides.begin(),
+                  cfg->fOverrides.end());
+    for (size_t l = 0; l < layers.size(); ++l) {
+      TIter it(layers[l]->GetTable());
+      TEnvRec* rec;
+      while ((rec = dynamic_cast<TEnvRec*>(it.Next())))
+        values[rec->GetName()] = rec->GetValue();
+    }
+  }
+
+  fKeyTree.Clear();
+  std::map<std::string_view, const char*>::const_iterator it = values.begin();
+  for (; it != values.end(); ++it)
+    fKeyTree.Add(it->first.data(), it->second);
+  fKeyTree.Build();
+  fKeyTreeGeneration = generation;
+  return fKeyTree;
+}
+
+CmdLineSnapshot CmdLineConfig::Snapshot() {
+  GetEnv();
+  return fTables;
+}
+
+void CmdLineConfig::Restore(const CmdLineSnapshot& snapshot) {
+  GetEnv();
+  NewGeneration();
+
+  // buckets still shared with the snapshot did not change
+  for (Int_t t = 0; t < CmdLineSnapshot::kNTables; ++t) {
+    TEnv* env = fLayers[t ? kLayerRuntime : kLayerCmdLine];
+    for (Int_t b = 0; b < CmdLineSnapshot::kNBuckets; ++b) {
+      const std::shared_ptr<const CmdLineSnapshot::Bucket>& now =
+          fTables.fBuckets[t][b];
+      const std::shared_ptr<const CmdLineSnapshot::Bucket>& then =
+          snapshot.fBuckets[t][b];
+      if (now == then) continue;
+
+      CmdLineSnapshot::Bucket::const_iterator it;
+      if (now) {
+        for (it = now->begin(); it != now->end(); ++it) {
+          if (then && then->count(it->first)) continue;
+          TObject* obj = env->Lookup(it->first);
+          if (obj) delete env->GetTable()->Remove(obj);
+          KeyChanged(it->first);
+        }
+      }
+      if (then) {
+        for (it = then->begin(); it != then->end(); ++it) {
+          CmdLineSnapshot::Bucket::const_iterator old;
+          if (now && (old = now->find(it->first)) != now->end() &&
+              old->second == it->second)
+            continue;
+          env->SetValue(it->first, it->second);
+          KeyChanged(it->first);
+        }
+      }
+      fTables.fBuckets[t][b] = then;
+    }
+  }
+
+  DispatchChanges();
+}
+
+void CmdLineConfig::KeyChanged(const TString& key) {
+  Journal(key);
+  if (!key.BeginsWith("CmdLine.")) return;
+
+  CmdLineOption* opt = nullptr;
+  for (CmdLineConfig* cfg = this; cfg && !opt; cfg = cfg->fParent) {
+    Options::const_iterator it = cfg->fOpts.find(key.Data() + 8);
+    if (it != cfg->fOpts.end()) opt = it->second;
+  }
+  if (opt) MarkChanged(opt);
+}
+
+void CmdLineConfig::SetLayerValue(Layer layer, const char* name,
+                                  const char* value) {
+  GetEnv();
+  fLayers[layer]->SetValue(name, value);
+  Track(layer, name);
+  NewGeneration();
+  Journal(name);
+}
+
+TEnv* CmdLineConfig::GetLayer(Layer layer) {
+  GetEnv();
+  return fLayers[layer];
+}
+
+void CmdLineConfig::ClearLayer(Layer layer) {
+  GetEnv();
+  TEnv* env = fLayers[layer];
+  fLayers[layer] = new TEnv("");
+  if (layer == kLayerCmdLine) fTables.Clear(0);
+  if (layer == kLayerRuntime) fTables.Clear(1);
+  Forget(env);
+}
+
+void CmdLineConfig::PushLayer() {
+  GetEnv();
+  fOverrides.push_back(new TEnv(""));
+}
+
+void CmdLineConfig::PopLayer() {
+  if (fOverrides.empty()) return;
+  TEnv* env = fOverrides.back();
+  fOverrides.pop_back();
+  Forget(env);
+}
+
+void CmdLineConfig::Forget(TEnv* env) {
+  // the keys of the layer are resolved again, the changed options reported
+  NewGeneration();
+  TIter it(env->GetTable());
+  TEnvRec* rec;
+  while ((rec = dynamic_cast<TEnvRec*>(it.Next())))
+    KeyChanged(rec->GetName());
+  delete env;
+}
+
+void CmdLineConfig::Merge(TEnv* env) {
+  // parents first, so that the records of this context take precedence
+  std::vector<CmdLineConfig*> chain;
+  for (CmdLineConfig* cfg = this; cfg; cfg = cfg->fParent)
+    chain.insert(chain.begin(), cfg);
+
+  for (size_t c = 0; c < chain.size(); ++c) {
+    CmdLineConfig* cfg = chain[c];
+    cfg->GetEnv();
+    std::vector<TEnv*> layers(cfg->fLayers + kLayerGlobal,
+                              cfg->fLayers + kNLayers);
+    layers.insert(layers.end(), cfg->fOverrides.begin(),
+                  cfg->fOverrides.end());
+    for (size_t l = 0; l < layers.size(); ++l) {
+      TIter it(layers[l]->GetTable());
+      TEnvRec* rec;
+      while ((rec = dynamic_cast<TEnvRec*>(it.Next()))) {
+        // levels of the rc files are kept, all the rest overwrites them
+        EEnvLevel level = rec->GetLevel();
+        if (c || l > kLayerUser - kLayerGlobal || env->Lookup(rec->GetName()))
+          level = kEnvChange;
+        env->SetValue(rec->GetName(), rec->GetValue(), level);
+      }
+    }
+  }
+}
+
+void CmdLineConfig::Erase(const char* name) {
+  // no need to load the rc files just to remove the value
+  if (!fLayers[kLayerRuntime]) return;
+
+  std::vector<TEnv*> layers(fLayers + kLayerGlobal, fLayers + kNLayers);
+  layers.insert(layers.end(), fOverrides.begin(), fOverrides.end());
+  for (size_t l = 0; l < layers.size(); ++l) {
+    TObject* obj = layers[l]->Lookup(name);
+    if (obj) delete layers[l]->GetTable()->Remove(obj);
+  }
+  fTables.Erase(0, name);
+  fTables.Erase(1, name);
+  NewGeneration();
+  Journal(name);
+}
+
+CmdLineConfig::Override::Override(CmdLineConfig* config)
+    : fConfig(config ? config : Current()) {
+  fConfig->PushLayer();
+}
+
+CmdLineConfig::Override::~Override() {
+  fConfig->PopLayer();
+  fConfig->DispatchChanges();
+}
+
+void CmdLineConfig::SaveState(CmdLineState& state) {
+  Scope scope(this);
+  state.Clear();
+
+  TEnv env("");
+  Merge(&env);
+  TIter it(env.GetTable());
+  TEnvRec* rec;
+  while ((rec = dynamic_cast<TEnvRec*>(it.Next()))) {
+    state.fEnvNames.push_back(rec->GetName());
+    state.fEnvValues.push_back(rec->GetValue());
+    state.fEnvLevels.push_back(rec->GetLevel());
+  }
+
+  // options of the parent contexts first, unless hidden by one of a child
+  std::vector<CmdLineConfig*> chain;
+  for (CmdLineConfig* c = this; c; c = c->fParent)
+    chain.insert(chain.begin(), c);
+
+  for (size_t c = 0; c < chain.size(); ++c) {
+    for (size_t o = 0; o < chain[c]->_map_opts.size(); ++o) {
+      std::string_view name = chain[c]->_map_opts[o];
+      Bool_t hidden = kFALSE;
+      for (size_t h = c + 1; h < chain.size() && !hidden; ++h)
+        hidden = chain[h]->fOpts.count(name) > 0;
+      if (hidden) continue;
+
+      CmdLineOption* entry = chain[c]->fOpts[name];
+      // string options without a default have no value to store
+      const char* cp = entry->Getvalue("CmdLine." + entry->fName);
+      if (!cp) continue;
+      state.fOptNames.push_back(entry->fName.Data());
+      state.fOptTypes.push_back(entry->fType);
+      state.fOptValues.push_back(cp);
+    }
+  }
+
+  ListMap::const_iterator ait = _map_args.begin();
+  while (ait != _map_args.end()) {
+    CmdLineArg* arg = fArgs[*ait++];
+    state.fArgNames.push_back(arg->fName);
+    state.fArgTypes.push_back(arg->fType);
+    state.fArgValues.push_back(arg->fValue);
+  }
+
+  if (fGreedy) state.fGreedyType = fGreedy->fType;
+  for (size_t i = 0; i < fGreedyArgs.size(); ++i)
+    state.fGreedyValues.push_back(fGreedyArgs[i]->fValue);
+}
+
+void CmdLineConfig::LoadState(const CmdLineState& state) {
+  Scope scope(this);
+  InheritArguments();
+
+  // the stored table replaces the rc files, nothing is parsed here
+  GetEnv();
+  for (Int_t l = kLayerGlobal; l < kNLayers; ++l) {
+    delete fLayers[l];
+    fLayers[l] = new TEnv("");
+  }
+  fTables.Clear(0);
+  fTables.Clear(1);
+  fRcFiles.clear();
+
+  for (size_t i = 0; i < state.fEnvNames.size(); ++i)
+    fLayers[kLayerUser]->SetValue(state.fEnvNames[i], state.fEnvValues[i],
+                                  (EEnvLevel)state.fEnvLevels[i]);
+  NewGeneration();
+  JournalAll();
+
+  for (size_t i = 0; i < state.fOptNames.size(); ++i) {
+    CmdLineOption* entry = FindOption(state.fOptNames[i]);
+    if (entry && entry->fType != state.fOptTypes[i] &&
+        !(entry->fType == CmdLineOption::kStringNotChecked &&
+          state.fOptTypes[i] == CmdLineOption::kString))
+      std::cerr << "CmdLineConfig: stored option '" << state.fOptNames[i]
+                << "' has different type than the registered one" << std::endl;
+    SetLayerValue(kLayerCmdLine, "CmdLine." + state.fOptNames[i],
+                  state.fOptValues[i]);
+    if (entry) {
+      Validate(entry, "stored state");
+      MarkChanged(entry);
+    }
+  }
+
+  for (size_t i = 0; i < state.fArgNames.size(); ++i) {
+    CmdLineArg* arg = FindArgument(state.fArgNames[i]);
+    if (!arg) {
+      std::cerr << "CmdLineConfig: stored argument '" << state.fArgNames[i]
+                << "' is not registered" << std::endl;
+      continue;
+    }
+    arg->SetValue(state.fArgValues[i], "stored state");
+  }
+
+  ClearGreedy();
+  for (size_t i = 0; i < state.fGreedyValues.size(); ++i)
+    AddGreedy((CmdLineArg::OptionType)state.fGreedyType,
+              state.fGreedyValues[i], "stored state");
+  fGreedyRange.BuildIndex();
+
+  DispatchChanges();
 }
 
 void CmdLineConfig::ClearOptions() {
@@ -360,44 +1800,74 @@ void CmdLineConfig::ClearOptions() {
   //     ++it;
   //   }
 
-  fgOpts.clear();
-  fgArgs.clear();
-  fgGreedy.clear();
-  fGreedyPosition = -1;
-  _map_args.clear();
-  _map_opts.clear();
+  CmdLineConfig* cfg = Current();
+  cfg->DestroyExpanded();
+  cfg->fOpts.clear();
+  cfg->fArgs.clear();
+  cfg->ClearGreedy();
+  cfg->fGreedy = nullptr;
+  cfg->fGreedyPosition = -1;
+  cfg->_map_args.clear();
+  cfg->_map_opts.clear();
+  cfg->fSubcommands.clear();
+  cfg->fSubcommand = "";
+  delete cfg->fLayers[kLayerDefaults];
+  cfg->fLayers[kLayerDefaults] = new TEnv("");
+
+  std::lock_guard<std::mutex> lock(cfg->fValuesMutex);
+  cfg->fValues.clear();
+}
+
+void CmdLineConfig::DestroyExpanded() {
+  // expanded options are placed in the arena, which releases the memory
+  Options::iterator it = fOpts.begin();
+  while (it != fOpts.end()) {
+    CmdLineOption* opt = it->second;
+    if (!opt->TestBit(CmdLineOption::kExpanded)) {
+      ++it;
+      continue;
+    }
+    it = fOpts.erase(it);
+    opt->fConfig = nullptr;
+    opt->~CmdLineOption();
+  }
 }
 
 CmdLineOption* CmdLineConfig::FindOption(const char* name) {
-  if (0 == fgOpts.size()) return nullptr;
+  for (CmdLineConfig* cfg = Current(); cfg; cfg = cfg->fParent) {
+    if (0 == cfg->fOpts.size()) continue;
 
-  Options::const_iterator it = fgOpts.find(name);
-  if (fgOpts.end() != it) return it->second;
+    Options::const_iterator it = cfg->fOpts.find(name);
+    if (cfg->fOpts.end() != it) return it->second;
+  }
 
   return nullptr;
 }
 
 CmdLineArg* CmdLineConfig::FindArgument(const char* name) {
-  if (0 == fgArgs.size()) return nullptr;
+  for (CmdLineConfig* cfg = Current(); cfg; cfg = cfg->fParent) {
+    if (0 == cfg->fArgs.size()) continue;
 
-  Positional::const_iterator it = fgArgs.find(name);
-  if (fgArgs.end() != it) return it->second;
+    Positional::const_iterator it = cfg->fArgs.find(name);
+    if (cfg->fArgs.end() != it) return it->second;
+  }
 
   return nullptr;
 }
 
 void CmdLineConfig::Insert(CmdLineOption* opt) {
-  Options::const_iterator it = fgOpts.begin();
+  if (fOpts.count(opt->fName.View())) {
+    std::cerr << "CmdLineOption: option '" << opt->fName
+              << "' already exists -> fix it" << std::endl;
+    exit(1);
+  }
 
-  while (it != fgOpts.end()) {
+  // only options with a tag are compared with all others
+  Options::const_iterator it = fOpts.begin();
+  while (opt->fCmdArg != "" && it != fOpts.end()) {
     CmdLineOption* entry = (it++)->second;
 
-    if (entry->fName == opt->fName) {
-      std::cerr << "CmdLineOption: option '" << opt->fName
-                << "' already exists -> fix it" << std::endl;
-      exit(1);
-    }
-    if (opt->fCmdArg != "" && entry->fCmdArg == opt->fCmdArg) {
+    if (entry->fCmdArg == opt->fCmdArg) {
       std::cerr << "CmdLineOption: options '" << opt->fName << "' and '"
                 << entry->fName << "' share tag '" << opt->fCmdArg << "'"
                 << std::endl;
@@ -405,8 +1875,71 @@ void CmdLineConfig::Insert(CmdLineOption* opt) {
     }
   }
 
-  fgOpts[opt->fName] = opt;
-  _map_opts.push_back(opt->fName.Data());
+  fOpts[opt->fName.View()] = opt;
+  _map_opts.push_back(opt->fName.View());
+  // values are not changed, the option is converted when first read
+  fOptionsStamp = ++gGeneration;
+}
+
+void CmdLineConfig::Insert(const std::vector<CmdLineOption*>& opts) {
+  if (opts.empty()) return;
+
+  Options::iterator hint = fOpts.lower_bound(opts[0]->fName.View());
+  for (size_t i = 0; i < opts.size(); ++i) {
+    size_t size = fOpts.size();
+    hint = fOpts.emplace_hint(hint, opts[i]->fName.View(), opts[i]);
+    if (fOpts.size() == size) {
+      std::cerr << "CmdLineOption: option '" << opts[i]->fName
+                << "' already exists -> fix it" << std::endl;
+      exit(1);
+    }
+    ++hint;
+    _map_opts.push_back(opts[i]->fName.View());
+  }
+  fOptionsStamp = ++gGeneration;
+}
+
+TEnvRec* CmdLineConfig::InsertDefault(const CmdLineOption* opt) {
+  TString value;
+  switch (opt->fType) {
+    case CmdLineOption::kFlag:
+    case CmdLineOption::kBool:
+    case CmdLineOption::kInt:
+      value = TString::Format("%d", opt->fDef.fInt);
+      break;
+    case CmdLineOption::kDouble: {
+      // shortest form which converts back to the same number
+      char buf[32];
+      std::to_chars_result res =
+          std::to_chars(buf, buf + sizeof(buf), opt->fDef.fDouble);
+      value = TString(buf, res.ptr - buf);
+      break;
+    }
+    default:
+      // empty strings are no defaults
+      if (!opt->GetDefString()) return nullptr;
+      value = opt->GetDefString();
+      break;
+  }
+  TString key = "CmdLine." + opt->fName;
+  fLayers[kLayerDefaults]->SetValue(key, value);
+  return fLayers[kLayerDefaults]->Lookup(key);
+}
+
+void CmdLineConfig::Remove(CmdLineOption* opt) {
+  // also from the options in the order of declaration
+  for (size_t o = 0; o < _map_opts.size(); ++o) {
+    if (_map_opts[o] != opt->fName.View()) continue;
+    _map_opts.erase(_map_opts.begin() + o);
+    break;
+  }
+  fOpts.erase(opt->fName.View());
+  NewGeneration();
+  TObject* obj = fLayers[kLayerDefaults]->Lookup("CmdLine." + opt->fName);
+  if (obj) delete fLayers[kLayerDefaults]->GetTable()->Remove(obj);
+
+  std::lock_guard<std::mutex> lock(fValuesMutex);
+  fValues.erase(opt);
 }
 
 void CmdLineConfig::Insert(CmdLineArg* arg) {
@@ -415,14 +1948,14 @@ void CmdLineConfig::Insert(CmdLineArg* arg) {
       std::cerr << "Only one greedy parameter allowed." << std::endl;
       abort();
     }
-    fGreedyPosition = fgArgs.size();
+    fGreedyPosition = fArgs.size();
     fGreedy = arg;
     return;
   }
 
-  Positional::const_iterator it = fgArgs.begin();
+  Positional::const_iterator it = fArgs.begin();
 
-  while (it != fgArgs.end()) {
+  while (it != fArgs.end()) {
     CmdLineArg* entry = (it++)->second;
     if (entry->fName == arg->fName) {
       std::cerr << "CmdLineOption: argument '" << arg->fName
@@ -431,7 +1964,7 @@ void CmdLineConfig::Insert(CmdLineArg* arg) {
     }
   }
 
-  fgArgs.insert(std::pair<std::string, CmdLineArg*>(arg->fName.Data(), arg));
+  fArgs.insert(std::pair<std::string, CmdLineArg*>(arg->fName.Data(), arg));
   _map_args.push_back(arg->fName.Data());
 }
 
@@ -465,7 +1998,7 @@ Bool_t CmdLineConfig::CheckCmdLineSpecial(int argc, char** argv, int i) {
         void* dirp = gSystem->OpenDirectory(extra);
         if (dirp == 0) {
           std::cout << "Reading extra rc file: " << extra << std::endl;
-          CmdLineConfig::instance()->GetEnv()->ReadFile(extra, kEnvChange);
+          Current()->ReadExtraFile(extra);
         } else {
           if (!extra.EndsWith("/")) extra += "/";
           const char* localname = 0;
@@ -474,8 +2007,7 @@ Bool_t CmdLineConfig::CheckCmdLineSpecial(int argc, char** argv, int i) {
             if (strName.EndsWith(".rc")) {
               std::cout << "Reading extra fc file: " << extra + strName
                         << std::endl;
-              CmdLineConfig::instance()->GetEnv()->ReadFile(extra + strName,
-                                                            kEnvChange);
+              Current()->ReadExtraFile(extra + strName);
             }
           }
           gSystem->FreeDirectory(dirp);
@@ -488,6 +2020,9 @@ Bool_t CmdLineConfig::CheckCmdLineSpecial(int argc, char** argv, int i) {
 }
 
 void CmdLineConfig::PrintHelp(int argc, char** argv) {
+  CmdLineConfig* cfg = Current();
+  CmdLineConfig* acfg = cfg->ArgumentsContext();
+
   std::cout << "Usage: ";
   if (argc and argv)
     std::cout << argv[0];
@@ -495,81 +2030,118 @@ void CmdLineConfig::PrintHelp(int argc, char** argv) {
     std::cout << "this_app";
   std::cout << " [options]";
 
-  if (fgArgs.size()) {
+  // subcommands are listed until one is selected
+  const std::vector<Subcommand>* commands = nullptr;
+  TString selected;
+  for (CmdLineConfig* c = cfg; c; c = c->fParent) {
+    if (selected.IsNull()) selected = c->fSubcommand;
+    if (!commands && c->fSubcommands.size()) commands = &c->fSubcommands;
+  }
+  if (commands) {
+    if (selected.IsNull())
+      std::cout << " <command>";
+    else
+      std::cout << " " << selected;
+  }
+
+  if (acfg->fArgs.size()) {
     Int_t pos = 0;
-    ListMap::const_iterator ait = _map_args.begin();
+    ListMap::const_iterator ait = acfg->_map_args.begin();
 
-    while (ait != _map_args.end()) {
-      if (fGreedyPosition == pos) std::cout << " " << fPosText;
+    while (ait != acfg->_map_args.end()) {
+      if (acfg->fGreedyPosition == pos) std::cout << " " << cfg->fPosText;
       std::cout << " " << *ait++;
       ++pos;
     }
-    if (pos == fGreedyPosition) std::cout << " " << fPosText;
+    if (pos == acfg->fGreedyPosition) std::cout << " " << cfg->fPosText;
   }
   std::cout << std::endl;
   std::cout << "  -h                  show this help" << std::endl;
 
-  if (0 == fgOpts.size()) return;
+  // options of the parent contexts first
+  std::vector<CmdLineConfig*> chain;
+  for (CmdLineConfig* c = cfg; c; c = c->fParent)
+    chain.insert(chain.begin(), c);
 
-  ListMap::const_iterator oit = _map_opts.begin();
-  while (oit != _map_opts.end())
-    fgOpts[*oit++]->PrintHelp();
+  for (size_t c = 0; c < chain.size(); ++c) {
+    for (size_t o = 0; o < chain[c]->_map_opts.size(); ++o)
+      chain[c]->fOpts[chain[c]->_map_opts[o]]->PrintHelp();
+  }
 
-  ListMap::const_iterator ait = _map_args.begin();
+  ListMap::const_iterator ait = acfg->_map_args.begin();
 
   Int_t pos = 0;
-  while (ait != _map_args.end()) {
-    if (fGreedyPosition == pos)
-      if (fGreedy) fGreedy->PrintHelp(fPosText);
-    fgArgs[*ait++]->PrintHelp();
+  while (ait != acfg->_map_args.end()) {
+    if (acfg->fGreedyPosition == pos)
+      if (acfg->fGreedy) acfg->fGreedy->PrintHelp(cfg->fPosText);
+    acfg->fArgs[*ait++]->PrintHelp();
     ++pos;
   }
 
-  if (pos == fGreedyPosition)
-    if (fGreedy) fGreedy->PrintHelp(fPosText);
+  if (pos == acfg->fGreedyPosition)
+    if (acfg->fGreedy) acfg->fGreedy->PrintHelp(cfg->fPosText);
+
+  if (commands && selected.IsNull()) {
+    std::cout << "Commands:" << std::endl;
+    for (size_t i = 0; i < commands->size(); ++i)
+      std::cout << "  " << resetiosflags(std::ios::adjustfield)
+                << setiosflags(std::ios::left) << std::setw(20)
+                << (*commands)[i].fName << (*commands)[i].fHelp
+                << resetiosflags(std::ios::adjustfield) << std::endl;
+  }
 }
 
 void CmdLineConfig::Print() {
-  if (0 == fgOpts.size()) return;
-  std::cout << "Current settings:" << std::endl;
+  CmdLineConfig* cfg = Current();
+  Bool_t header = kFALSE;
 
-  Options::const_iterator it = fgOpts.begin();
-  CmdLineOption* entry;
-  while ((entry = (*it++).second)) {
-    entry->Print();
+  for (CmdLineConfig* c = cfg; c; c = c->fParent) {
+    Options::const_iterator it = c->fOpts.begin();
+    while (it != c->fOpts.end()) {
+      CmdLineOption* entry = (it++)->second;
+      // skip options shadowed by a child context
+      if (c != cfg && FindOption(entry->fName) != entry) continue;
+      if (!header) std::cout << "Current settings:" << std::endl;
+      header = kTRUE;
+      entry->Print();
+    }
   }
 }
 
 void CmdLineConfig::RestoreDefaults() {
-  instance()->GetEnv();
-
-  Options::const_iterator it = fgOpts.begin();
-
-  while (it != fgOpts.end()) {
-    CmdLineOption* entry = (it++)->second;
-    if (entry->fCmdArg == "") continue;
-
-    switch (entry->fType) {
-      case CmdLineOption::kFlag:
-        CmdLineConfig::instance()->GetEnv()->SetValue("CmdLine." + entry->fName,
-                                                      kFALSE);
-        break;
-      case CmdLineOption::kBool:
-      case CmdLineOption::kInt:
-        CmdLineConfig::instance()->GetEnv()->SetValue("CmdLine." + entry->fName,
-                                                      entry->fDefInt);
-        break;
-      case CmdLineOption::kDouble:
-        CmdLineConfig::instance()->GetEnv()->SetValue("CmdLine." + entry->fName,
-                                                      entry->fDefDouble);
-        break;
-      case CmdLineOption::kString:
-      case CmdLineOption::kStringNotChecked:
-        CmdLineConfig::instance()->GetEnv()->SetValue("CmdLine." + entry->fName,
-                                                      entry->fDefString);
-        break;
-      default:
-        break;
+  // options with a switch get their built-in defaults over the values of the
+  // rc files, in the command line layer, so a command line read afterwards
+  // still applies; values set at runtime are removed
+  CmdLineConfig* cfg = Current();
+  cfg->GetEnv();
+  cfg->NewGeneration();
+  Scope scope(cfg);
+  for (CmdLineConfig* c = cfg; c; c = c->fParent) {
+    Options::const_iterator it = c->fOpts.begin();
+    while (it != c->fOpts.end()) {
+      CmdLineOption* entry = (it++)->second;
+      if (entry->fCmdArg == "") continue;
+      if (c != cfg && cfg->FindOption(entry->fName) != entry) continue;
+
+      TString key = "CmdLine." + entry->fName;
+      TObject* obj = cfg->fLayers[kLayerRuntime]->Lookup(key);
+      if (obj) delete cfg->fLayers[kLayerRuntime]->GetTable()->Remove(obj);
+      cfg->Track(kLayerRuntime, key);
+      TEnvRec* rec = cfg->LookupDefault(key);
+      obj = cfg->fLayers[kLayerCmdLine]->Lookup(key);
+      if (obj) delete cfg->fLayers[kLayerCmdLine]->GetTable()->Remove(obj);
+      if (rec) cfg->fLayers[kLayerCmdLine]->SetValue(key, rec->GetValue());
+      cfg->Track(kLayerCmdLine, key);
+      cfg->MarkChanged(entry);
     }
   }
+  cfg->DispatchChanges();
+}
+
+void CmdLineConfig::ClearValues() {
+  // values of the rc files and defaults are below the dropped layers
+  CmdLineConfig* cfg = Current();
+  cfg->ClearLayer(kLayerCmdLine);
+  cfg->ClearLayer(kLayerRuntime);
+  cfg->DispatchChanges();
 }
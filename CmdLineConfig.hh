@@ -29,32 +29,120 @@
 #ifndef _CMDLINECONFIG_HH
 #define _CMDLINECONFIG_HH
 
+#include <atomic>
+#include <deque>
+#include <functional>
 #include <list>
 #include <map>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
 
 #include <TString.h>
 #include <TSystem.h>
 
 #include "CmdLineArg.hh"
+#include "CmdLineGlob.hh"
 #include "CmdLineOption.hh"
+#include "CmdLineRange.hh"
+#include "CmdLineSnapshot.hh"
+#include "CmdLineState.hh"
+#include "CmdLineTree.hh"
 
 class TEnv;
+class TEnvRec;
+class CmdLineShm;
 
 enum ParameterSource { kSql, kFile, kImportExport, kFileImport };
 
 typedef std::map<std::string, CmdLineArg*> Positional;
 typedef std::vector<CmdLineArg*> Greedy;
 
+typedef std::vector<CmdLineOption*> ChangedOptions;
+typedef std::vector<std::pair<TString, TString>> KeyValues;
+typedef std::function<void(const ChangedOptions& changed)> ChangeCallback;
+typedef std::function<void(CmdLineConfig& config)> SubcommandFactory;
+
 class CmdLineConfig {
 protected:
   CmdLineConfig();
   CmdLineConfig(const char* name);
-  virtual ~CmdLineConfig();
 
 public:
+  CmdLineConfig(CmdLineConfig* parent, const char* name = nullptr);
+  virtual ~CmdLineConfig();
+
   static CmdLineConfig* instance(const char* name = nullptr);
+  static CmdLineConfig* Current();
+
+  /// Makes a context the active one of the calling thread for the lifetime of
+  /// the scope. All static members act on the active context.
+  class Scope {
+  public:
+    Scope(CmdLineConfig* config);
+    ~Scope();
+
+  private:
+    CmdLineConfig* fPrevious;
+  };
+
+  CmdLineConfig* GetParent() const { return fParent; }
+
+  /// Layers of values, a key is resolved from the top down: scoped
+  /// overrides, runtime, command line, extra rc files, user rc files, global
+  /// rc files, then the layers of the parent and the built-in defaults.
+  enum Layer {
+    kLayerDefaults,
+    kLayerGlobal,
+    kLayerUser,
+    kLayerExtra,
+    kLayerCmdLine,
+    kLayerRuntime,
+    kNLayers
+  };
+
+  /// Pushes an override layer on top of all others for the lifetime of the
+  /// object, SetValue() writes there. Leaving the scope forgets the values
+  /// set in it and calls the change callbacks.
+  class Override {
+  public:
+    Override(CmdLineConfig* config = nullptr);
+    ~Override();
+
+  private:
+    CmdLineConfig* fConfig;
+  };
 
   void ReadCmdLine(int argc, char** argv);
+  /// Parses a command line not given to the process, e.g. a job of a batch.
+  /// -h, -p and -extra-sorterrc are not accepted there; errors are reported
+  /// and return kFALSE instead of ending the process.
+  Bool_t ReadJobLine(int argc, char** argv);
+
+  /// Registers a subcommand, given on the command line as the first
+  /// positional argument. Only the factory of the selected subcommand is
+  /// called, it defines the options and arguments of the subcommand with
+  /// New() of the context it gets.
+  void AddSubcommand(const char* name, const char* help,
+                     const SubcommandFactory& factory);
+  /// Name of the selected subcommand, empty if none.
+  const TString& GetSubcommand() const { return fSubcommand; }
+
+  /// Option or argument of this context, deleted with it.
+  template <typename T, typename... Args> T* New(Args&&... args) {
+    Scope scope(this);
+    T* obj = new T(std::forward<Args>(args)...);
+    Own(obj);
+    return obj;
+  }
+
+  /// Registers a callback called once after the command line, an rc file or
+  /// a stored state is applied. It gets the changed options among those
+  /// given, or all changed options if none are given.
+  Int_t AddCallback(const ChangeCallback& callback,
+                    const ChangedOptions& options = ChangedOptions());
+  void RemoveCallback(Int_t id);
 
   // special treatment for the following parameters are needed
 
@@ -68,16 +156,129 @@ public:
   static const TString GetParameterDrain(const char* objectname);
   static void SetParameterDrain(const char* objectname, const char* source);
 
+  /// File in the ':' separated search path, like gSystem->Which(). Results
+  /// are cached, see CmdLineResolver.
   static const TString GetResource(const char* path, const char* file,
                                    EAccessMode mode = kFileExists);
+  /// File in the search path of DataDir.
+  static const TString GetDataResource(const char* file,
+                                       EAccessMode mode = kFileExists);
 
-  static const void SetPositionalText(const TString& text) { fPosText = text; }
-  static const Positional& GetPositionalArguments() { return fgArgs; }
-  static const Greedy& GetGreedyArguments() { return fgGreedy; }
+  static const void SetPositionalText(const TString& text) {
+    Current()->fPosText = text;
+  }
+  static const Positional& GetPositionalArguments() {
+    return Current()->ArgumentsContext()->fArgs;
+  }
+  static const Greedy& GetGreedyArguments() {
+    return Current()->ArgumentsContext()->fGreedyArgs;
+  }
+  /// All elements of int (and bool) greedy arguments, in order. Ranges are
+  /// expanded on the first call.
+  static const std::vector<Int_t>& GetGreedyIntArguments();
+  /// Elements of int greedy arguments, ranges not expanded.
+  static const CmdLineRange& GetGreedyRange() {
+    return Current()->ArgumentsContext()->fGreedyRange;
+  }
+  /// All elements of double greedy arguments, in order.
+  static const std::vector<Double_t>& GetGreedyDoubleArguments() {
+    return Current()->ArgumentsContext()->fGreedyDoubles;
+  }
 
+  /// Reads the rc files if not done yet. Returns the layer of the runtime
+  /// values; call Invalidate() after modifying it directly.
   TEnv* GetEnv();
+  TEnv* GetLayer(Layer layer);
+  void PushLayer();
+  void PopLayer();
+  size_t GetNOverrides() const { return fOverrides.size(); }
+  /// Copies the records in effect into the environment.
+  void Merge(TEnv* env);
+  /// Reads the rc files again, values set since then are lost.
+  void Reload();
+  /// Sets the values in the top override layer, or in the runtime layer, and
+  /// reads the rc files and extra rc files again if requested, all in one
+  /// step: lookups see either the old or the new records. Only the changed
+  /// keys are resolved again, the change callbacks are called once. Returns
+  /// the number of changed keys.
+  Int_t Update(const KeyValues& values, Bool_t files = kFALSE);
+  /// Rc files and extra rc files read, in order.
+  const std::vector<TString>& GetRcFiles() const { return fRcFiles; }
+  /// Makes the default context take the records from the shared memory
+  /// segment published by cmdlineshmd instead of reading the rc files. The
+  /// CMDLINE_SHM environment variable has the same effect.
+  static void SetSharedEnv(const char* name);
+  /// Makes the default context read the rc files in a background thread,
+  /// started when the context is created, or at once if it exists already.
+  static void SetAsyncLoad(Bool_t async);
+  /// Starts reading the rc files in a background thread, the first access to
+  /// the values waits for it. The files found depend on the options
+  /// DefaultPath, IncludePath and Include; they are read again at the first
+  /// access if these options were defined or set in the meantime.
+  void LoadAsync();
+  /// Replaces the records by those of the shared segment.
+  Bool_t AttachSharedEnv(const char* name);
+  /// Takes over a newer version of the shared segment, if published.
+  Bool_t SyncSharedEnv();
+  /// Record of the key in the highest layer defining it, built-in defaults
+  /// excluded. Resolutions are cached until the key changes.
+  TEnvRec* Lookup(const char* name);
+  /// Record of the most specific pattern of the rc files matching the key,
+  /// see CmdLineGlob. The patterns are compiled again after they changed.
+  TEnvRec* LookupPattern(const char* name);
+  /// Record of the built-in default of an option.
+  TEnvRec* LookupDefault(const char* name);
+  const char* GetValue(const char* name, const char* dflt);
+  /// Sets the value in the top override layer, or in the runtime layer.
+  void SetValue(const char* name, const char* value);
+  /// Returns the value of the option converted to its type. Values are
+  /// validated when they are set, reading them only converts again after
+  /// their key or a pattern changed.
+  const CmdLineValue& GetTypedValue(const CmdLineOption* opt);
+  /// Must be called after the environment was modified directly.
+  void Invalidate();
+
+  /// Generation of the values, grows with every change in the context or its
+  /// parents. Generations of all contexts are comparable.
+  ULong64_t GetGeneration() const;
+  /// Generation the value of the key (or option) was last changed in.
+  ULong64_t GetModified(const char* key) const;
+  ULong64_t GetModified(const CmdLineOption* opt) const;
+  /// Appends the keys changed after the given generation, newest first.
+  /// Returns kFALSE if the journal does not reach back that far or all keys
+  /// changed (e.g. rc files were read), everything must be taken as changed.
+  Bool_t GetChanges(ULong64_t since, std::vector<TString>& keys) const;
+  /// Number of changes kept in the journal of the context, 1024 by default.
+  void SetJournalSize(size_t size);
+
+  /// Options of the context and its parents indexed by the components of
+  /// their names, with the values in effect. The index is rebuilt on the
+  /// first call after the configuration changed, views into it are valid
+  /// until then.
+  const CmdLineTree& GetOptionTree();
+  /// Keys of the rc files and values set, built-in defaults excluded.
+  const CmdLineTree& GetKeyTree();
+  /// Options below the prefix, e.g. "TH1I.Layer3", sorted by name.
+  CmdLineSpan<CmdLineTree::Entry> GetOptions(const char* prefix) {
+    return GetOptionTree().Find(prefix);
+  }
+  /// Keys below the prefix, e.g. "CmdLine.TH1I", sorted by name.
+  CmdLineSpan<CmdLineTree::Entry> GetKeys(const char* prefix) {
+    return GetKeyTree().Find(prefix);
+  }
+
+  /// Values of the command line and runtime layers, taken in constant time.
+  CmdLineSnapshot Snapshot();
+  /// Returns to the values of the snapshot; only the buckets modified since
+  /// are compared, the change callbacks get the changed options.
+  void Restore(const CmdLineSnapshot& snapshot);
+  void SaveState(CmdLineState& state);
+  void LoadState(const CmdLineState& state);
   static void ClearOptions();
+  /// Sets the options with a switch to their built-in defaults.
   static void RestoreDefaults();
+  /// Drops the command line and runtime values of the active context.
+  static void ClearValues();
   static CmdLineOption* FindOption(const char* name);
   static CmdLineArg* FindArgument(const char* name);
   static Bool_t CheckCmdLineSpecial(int argc, char** argv, int i);
@@ -85,35 +286,153 @@ public:
   static void Print();
 
 protected:
-  friend CmdLineOption::~CmdLineOption();
-  friend void CmdLineOption::Init(const char* name, const char* cmd,
-                                  const char* help);
+  friend class CmdLineOption;
+
+  friend class CmdLineSweep;
 
   friend CmdLineArg::~CmdLineArg();
   friend void CmdLineArg::Init(const char* name, const char* help, bool greedy);
 
   void Insert(CmdLineOption* opt);
-  void Remove(CmdLineOption* opt) { fgOpts.erase(opt->fName); }
+  /// Registers expanded options sorted by name, not defined yet. Names must
+  /// be unique, like for single options.
+  void Insert(const std::vector<CmdLineOption*>& opts);
+  void Remove(CmdLineOption* opt);
+  TEnvRec* InsertDefault(const CmdLineOption* opt);
+  void Erase(const char* name);
 
   void Insert(CmdLineArg* opt);
-  void Remove(CmdLineArg* opt) { fgArgs.erase(opt->fName.Data()); }
+  void Remove(CmdLineArg* opt) { fArgs.erase(opt->fName.Data()); }
 
 private:
+  void InheritArguments();
+  CmdLineConfig* ArgumentsContext();
+  void ReadExtraFile(const char* filename);
+  struct RcLoad;
+  RcLoad* NewLoad();
+  void FinishLoading(Bool_t apply);
+  void MarkChanged(CmdLineOption* opt);
+  void DispatchChanges();
+  void AddGreedy(CmdLineArg::OptionType type, const char* value,
+                 const char* location);
+  void ClearGreedy();
+  void Own(CmdLineOption* opt) { fOwnedOpts.push_back(opt); }
+  void Own(CmdLineArg* arg) { fOwnedArgs.push_back(arg); }
+  Bool_t ParseCmdLine(int argc, char** argv, Bool_t job);
+  /// Position of the subcommand, -1 if none, 0 on errors of a job.
+  Int_t SelectSubcommand(int argc, char** argv, Bool_t job);
+  void SetLayerValue(Layer layer, const char* name, const char* value);
+  void ClearLayer(Layer layer);
+  void Forget(TEnv* env);
+  void DestroyExpanded();
+  void Track(Layer layer, const char* name);
+  void KeyChanged(const TString& key);
+  void CompilePatterns();
+  void NewGeneration();
+  ULong64_t GetOptionsGeneration() const;
+  Bool_t IsChanged(const CmdLineOption* opt, ULong64_t since) const;
+  void Journal(const char* key);
+  void JournalAll();
+  void WriteBindings(const char* name);
+  Bool_t Validate(const CmdLineOption* opt, const char* location);
+  void Report(const CmdLineOption* opt, Bool_t ok, TEnvRec* rec,
+              const char* location);
+  void Retire(TEnv* env);
+  void ReleaseRetired();
+  void ValidateAll();
+  TString FindSource(const char* key) const;
+  ParameterSource Route(Bool_t drain, const char* name);
+  void BuildRoutes();
+
   static CmdLineConfig* inst;
-  static TEnv* fgEnv; // general environment
+  CmdLineConfig* fParent; // context to fall back to, nullptr for the default
+  TEnv* fLayers[kNLayers]; // layers of values, see Layer
+  std::vector<TEnv*> fOverrides; // pushed override layers, top last
+  CmdLineSnapshot fTables; //! command line and runtime values, shared
+  CmdLineArena fArena;     //! names and expanded options
+  CmdLineShm* fShm;       // shared segment the records are taken from
+  struct Retired {
+    ULong64_t fUpdate; // replacement the layer was retired by
+    TEnv* fEnv;
+  };
+  std::vector<Retired> fRetired; //! replaced layers, read by other threads
+  ULong64_t fUpdates;            //! number of replacements of layers
+  std::atomic<RcLoad*> fAsync; //! rc files read in the background
   TString name;
 
-  typedef std::map<TString, CmdLineOption*> Options;
-  static Options fgOpts;      // list of command line options
-  static Positional fgArgs;   // list of command line arguments
-  static Greedy fgGreedy;     // list of command line greedy arguments
-  static CmdLineArg* fGreedy; // greedy argument reference
-  static Int_t fGreedyPosition;
+  typedef std::map<std::string_view, CmdLineOption*> Options;
+  Options fOpts;           // list of command line options, keys in fArena
+  Positional fArgs;        // list of command line arguments
+  Greedy fGreedyArgs;      // list of command line greedy arguments, owned
+  CmdLineArg* fGreedy;     // greedy argument reference
+  Int_t fGreedyPosition;
+  Greedy fOwnedArgs;       // arguments created by and deleted with context
+  std::vector<Int_t> fGreedyInts;       // converted greedy int arguments
+  CmdLineRange fGreedyRange;            // greedy int arguments as ranges
+  std::vector<Double_t> fGreedyDoubles; // converted greedy double arguments
+
+  TString fPosText;
+
+  struct Subcommand {
+    TString fName;
+    TString fHelp;
+    SubcommandFactory fFactory;
+  };
+  std::vector<Subcommand> fSubcommands;
+  TString fSubcommand;                   // selected subcommand
+  std::vector<CmdLineOption*> fOwnedOpts; // options created by New()
+
+  struct ChangeHandler {
+    Int_t fId;
+    ChangeCallback fCallback;
+    ChangedOptions fOptions; // options of interest, empty for all
+  };
+  std::vector<ChangeHandler> fHandlers;
+  Int_t fNextHandlerId;
+  ChangedOptions fChanged; // options changed since the last dispatch
+
+  std::vector<TString> fRcFiles;    // rc files read, in order
+  std::vector<TString> fExtraFiles; // -extra-sorterrc files, in order
+  ULong64_t fStamp;                 // generation of the last change of values
+  ULong64_t fOptionsStamp;          // generation an option was last inserted
+
+  struct JournalEntry {
+    ULong64_t fGeneration;
+    TString fKey;
+  };
+  std::deque<JournalEntry> fJournal;      // changed keys, oldest first
+  size_t fJournalSize;                    // maximal length of the journal
+  ULong64_t fJournalLost;                 // older changes are not journaled
+  std::map<TString, ULong64_t> fModified; // last change of the keys
+  ULong64_t fModifiedAll;                 // last change of all keys
+
+  typedef std::unordered_map<std::string, TEnvRec*> Resolved;
+  Resolved fResolved;             //! records of the keys looked up
+  ULong64_t fResolvedGeneration;  //! generation fResolved is valid for
+  std::mutex fResolvedMutex;      //!
+  CmdLineGlob fGlob;              //! patterns of the keys
+  ULong64_t fGlobGeneration;      //! generation fGlob was compiled for
+  std::mutex fGlobMutex;          //!
+  std::unordered_map<const CmdLineOption*, CmdLineValue> fValues; //!
+  std::mutex fValuesMutex;                                        //!
+  std::map<TString, TString> fReported; //! malformed values reported
+
+  CmdLineTree fOptionTree;         //! options by components of the names
+  ULong64_t fOptionTreeGeneration; //! generation fOptionTree was built for
+  CmdLineTree fKeyTree;            //! keys by components
+  ULong64_t fKeyTreeGeneration;    //!
+  std::mutex fTreeMutex;           //!
 
-  static TString fPosText;
+  typedef std::unordered_map<std::string_view, ParameterSource> Routes;
+  Routes fRoutes[2];                //! source and drain types by object name
+  ParameterSource fDefaultRoute[2]; //! types of objects not in fRoutes
+  CmdLineArena fRouteArena;         //! names of fRoutes
+  ULong64_t fRoutesGeneration;      //! generation fRoutes were built for
+  std::mutex fRoutesMutex;          //!
 
   typedef std::list<std::string> ListMap;
-  static ListMap _map_opts, _map_args;
+  std::vector<std::string_view> _map_opts; // options in order of declaration
+  ListMap _map_args;
 
   ClassDef(CmdLineConfig, 0); // LCOV_EXCL_LINE
 };
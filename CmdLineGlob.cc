@@ -0,0 +1,422 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineGlob.cc
+  \brief
+
+  The patterns are translated into one nondeterministic automaton, whose
+  sets of states become the states of a deterministic one when a name first
+  reaches them. Numeric ranges are split into sequences of digit classes.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include "CmdLineGlob.hh"
+
+// states of the deterministic automaton kept before starting over
+static const size_t gMaxDStates = 4096;
+
+// kinds of components, more specific are greater
+enum { kKindDoubleStar, kKindStar, kKindWildcard, kKindLiteral };
+
+typedef std::vector<std::pair<char, char>> DigitPiece;
+
+// Splits [lo, hi], numbers of equal width, into sequences of digit classes.
+static void SplitDigits(const std::string& lo, const std::string& hi,
+                        DigitPiece prefix, std::vector<DigitPiece>& pieces) {
+  if (lo.empty()) {
+    pieces.push_back(prefix);
+    return;
+  }
+
+  size_t k = lo.size() - 1;
+  if (lo[0] == hi[0]) {
+    prefix.push_back(std::make_pair(lo[0], lo[0]));
+    SplitDigits(lo.substr(1), hi.substr(1), prefix, pieces);
+    return;
+  }
+
+  // the first digits in between take any digits after them
+  Bool_t zeros = lo.find_first_not_of('0', 1) == std::string::npos;
+  Bool_t nines = hi.find_first_not_of('9', 1) == std::string::npos;
+  char first = zeros ? lo[0] : lo[0] + 1;
+  char last = nines ? hi[0] : hi[0] - 1;
+  if (!zeros) {
+    DigitPiece piece = prefix;
+    piece.push_back(std::make_pair(lo[0], lo[0]));
+    SplitDigits(lo.substr(1), std::string(k, '9'), piece, pieces);
+  }
+  if (first <= last) {
+    DigitPiece piece = prefix;
+    piece.push_back(std::make_pair(first, last));
+    piece.insert(piece.end(), k, std::make_pair('0', '9'));
+    pieces.push_back(piece);
+  }
+  if (!nines) {
+    DigitPiece piece = prefix;
+    piece.push_back(std::make_pair(hi[0], hi[0]));
+    SplitDigits(std::string(k, '0'), hi.substr(1), piece, pieces);
+  }
+}
+
+static std::string Digits(ULong64_t value, Int_t width) {
+  return TString::Format("%0*llu", width, (unsigned long long)value).Data();
+}
+
+CmdLineGlob::CmdLineGlob() { Clear(); }
+
+Bool_t CmdLineGlob::IsPattern(const char* key) {
+  return strpbrk(key, "*?[{") != nullptr;
+}
+
+void CmdLineGlob::Clear() {
+  fPatterns.clear();
+  fRanks.clear();
+  fStates.clear();
+  fSets.clear();
+  fDStateIds.clear();
+  fDStates.clear();
+  fDAccept.clear();
+  fTransitions.clear();
+}
+
+Bool_t CmdLineGlob::Specific(const Specificity& a, const Specificity& b) {
+  size_t n = std::min(a.fKinds.size(), b.fKinds.size());
+  for (size_t i = 0; i < n; ++i)
+    if (a.fKinds[i] != b.fKinds[i]) return a.fKinds[i] > b.fKinds[i];
+  if (a.fKinds.size() != b.fKinds.size())
+    return a.fKinds.size() > b.fKinds.size();
+  if (a.fLiterals != b.fLiterals) return a.fLiterals > b.fLiterals;
+  return a.fIndex < b.fIndex;
+}
+
+CmdLineGlob::Specificity CmdLineGlob::Rank(const TString& pattern,
+                                           Int_t index) {
+  Specificity spec;
+  spec.fLiterals = 0;
+  spec.fIndex = index;
+
+  // wildcards and literals of the component outside of braces
+  std::string plain;
+  Bool_t wild = kFALSE;
+  Bool_t inClass = kFALSE;
+  Int_t depth = 0;
+  for (const char* p = pattern.Data();; ++p) {
+    if (*p == 0 || (*p == '.' && depth == 0 && !inClass)) {
+      Int_t kind = kKindWildcard;
+      if (!wild) kind = kKindLiteral;
+      if (plain == "*") kind = kKindStar;
+      if (plain == "**") kind = kKindDoubleStar;
+      spec.fKinds.push_back(kind);
+      if (*p == 0) break;
+      plain.clear();
+      wild = kFALSE;
+      continue;
+    }
+
+    if (inClass) {
+      inClass = *p != ']';
+      continue;
+    }
+    switch (*p) {
+      case '[':
+        inClass = kTRUE;
+        wild = kTRUE;
+        break;
+      case '{':
+        ++depth;
+        wild = kTRUE;
+        break;
+      case '}':
+        if (depth) --depth;
+        break;
+      case '*':
+      case '?':
+        wild = kTRUE;
+        if (depth == 0) plain += *p;
+        break;
+      default:
+        if (depth == 0) {
+          plain += *p;
+          ++spec.fLiterals;
+        }
+    }
+  }
+  return spec;
+}
+
+void CmdLineGlob::Compile(const std::vector<TString>& patterns) {
+  Clear();
+  Int_t start = NewState();
+
+  std::vector<Specificity> specs;
+  for (size_t i = 0; i < patterns.size(); ++i) {
+    Specificity spec = Rank(patterns[i], fPatterns.size());
+    // a bare '*' never matched the first or last component
+    if (spec.fKinds.front() == kKindStar || spec.fKinds.back() == kKindStar)
+      continue;
+
+    size_t nstates = fStates.size();
+    size_t nsets = fSets.size();
+    Int_t first = NewState();
+    const char* p = patterns[i].Data();
+    Int_t last = Parse(p, first, kFALSE);
+    if (last < 0) {
+      std::cerr << "CmdLineGlob: invalid pattern '" << patterns[i] << "'"
+                << std::endl;
+      fStates.resize(nstates);
+      fSets.resize(nsets);
+      continue;
+    }
+    fStates[start].fEpsilon.push_back(first);
+    fStates[last].fAccept = fPatterns.size();
+    fPatterns.push_back(patterns[i]);
+    specs.push_back(spec);
+  }
+
+  std::sort(specs.begin(), specs.end(), Specific);
+  fRanks.assign(specs.size(), 0);
+  for (size_t r = 0; r < specs.size(); ++r)
+    fRanks[specs[r].fIndex] = r;
+
+  std::vector<Int_t> initial(1, start);
+  AddDState(initial);
+}
+
+Int_t CmdLineGlob::NewState() {
+  State state = {-1, -1, std::vector<Int_t>(), -1};
+  fStates.push_back(state);
+  return fStates.size() - 1;
+}
+
+Int_t CmdLineGlob::AddTransition(Int_t from, const CharSet& set) {
+  fSets.push_back(set);
+  Int_t to = NewState();
+  fStates[from].fSet = fSets.size() - 1;
+  fStates[from].fNext = to;
+  return to;
+}
+
+Int_t CmdLineGlob::Parse(const char*& p, Int_t tail, Bool_t alternative) {
+  CharSet component;
+  component.set();
+  component.reset(0);
+  CharSet any = component;
+  component.reset('.');
+
+  while (*p) {
+    if (alternative && (*p == ',' || *p == '}')) return tail;
+
+    switch (*p) {
+      case '*': {
+        // the state loops back to itself on the characters
+        Bool_t components = p[1] == '*';
+        while (*p == '*')
+          ++p;
+        Int_t loop = NewState();
+        Int_t next = NewState();
+        fStates[tail].fEpsilon.push_back(loop);
+        fStates[tail].fEpsilon.push_back(next);
+        fSets.push_back(components ? any : component);
+        fStates[loop].fSet = fSets.size() - 1;
+        fStates[loop].fNext = tail;
+        tail = next;
+      } break;
+      case '?':
+        ++p;
+        tail = AddTransition(tail, component);
+        break;
+      case '[':
+        ++p;
+        tail = ParseClass(p, tail);
+        if (tail < 0) return -1;
+        break;
+      case '{': {
+        ++p;
+        Int_t end = NewState();
+        for (;;) {
+          Int_t first = NewState();
+          fStates[tail].fEpsilon.push_back(first);
+          Int_t last = Parse(p, first, kTRUE);
+          if (last < 0) return -1;
+          fStates[last].fEpsilon.push_back(end);
+          if (*p++ == '}') break;
+        }
+        tail = end;
+      } break;
+      default: {
+        CharSet set;
+        set.set((UChar_t)*p++);
+        tail = AddTransition(tail, set);
+      }
+    }
+  }
+  // alternatives end with '}'
+  return alternative ? -1 : tail;
+}
+
+Int_t CmdLineGlob::ParseClass(const char*& p, Int_t tail) {
+  const char* close = strchr(p, ']');
+  if (!close || close == p) return -1;
+  TString content(p, close - p);
+  p = close + 1;
+
+  // two numbers are a range of numbers, not of characters
+  Ssiz_t dash = content.Index("-");
+  if (dash > 0 && dash < content.Length() - 1) {
+    TString lo = content(0, dash);
+    TString hi = content(dash + 1, content.Length() - dash - 1);
+    if (lo.IsDigit() && hi.IsDigit() && (lo.Length() > 1 || hi.Length() > 1))
+      return ParseRange(lo, hi, tail);
+  }
+
+  CharSet set;
+  Bool_t negate = content[0] == '!' || content[0] == '^';
+  for (Ssiz_t i = negate ? 1 : 0; i < content.Length(); ++i) {
+    UChar_t first = content[i];
+    UChar_t last = first;
+    if (i + 2 < content.Length() && content[i + 1] == '-') {
+      last = content[i + 2];
+      i += 2;
+    }
+    for (UInt_t c = first; c <= last; ++c)
+      set.set(c);
+  }
+  if (negate) {
+    set.flip();
+    set.reset('.');
+    set.reset(0);
+  }
+  if (set.none()) return -1;
+  return AddTransition(tail, set);
+}
+
+Int_t CmdLineGlob::ParseRange(const TString& lo, const TString& hi,
+                              Int_t tail) {
+  if (lo.Length() > 18 || hi.Length() > 18) return -1;
+  ULong64_t from = lo.Atoll();
+  ULong64_t to = hi.Atoll();
+  if (from > to) std::swap(from, to);
+
+  std::vector<DigitPiece> pieces;
+  if ((lo.Length() > 1 && lo[0] == '0') || (hi.Length() > 1 && hi[0] == '0')) {
+    // leading zeros give all numbers the same width
+    Int_t width = std::max(lo.Length(), hi.Length());
+    SplitDigits(Digits(from, width), Digits(to, width), DigitPiece(), pieces);
+  } else {
+    Int_t width = Digits(from, 0).size();
+    ULong64_t power = 1;
+    for (Int_t w = 1; w < width; ++w)
+      power *= 10;
+    for (; from <= to; ++width, power *= 10) {
+      ULong64_t end = std::min(to, power * 10 - 1);
+      SplitDigits(Digits(from, 0), Digits(end, 0), DigitPiece(), pieces);
+      from = end + 1;
+    }
+  }
+
+  Int_t end = NewState();
+  for (size_t i = 0; i < pieces.size(); ++i) {
+    Int_t state = NewState();
+    fStates[tail].fEpsilon.push_back(state);
+    for (size_t d = 0; d < pieces[i].size(); ++d) {
+      CharSet set;
+      for (char c = pieces[i][d].first; c <= pieces[i][d].second; ++c)
+        set.set((UChar_t)c);
+      state = AddTransition(state, set);
+    }
+    fStates[state].fEpsilon.push_back(end);
+  }
+  return end;
+}
+
+Int_t CmdLineGlob::AddDState(std::vector<Int_t>& states) {
+  // states reached without characters belong to the set
+  std::vector<Bool_t> seen(fStates.size(), kFALSE);
+  for (size_t i = 0; i < states.size(); ++i)
+    seen[states[i]] = kTRUE;
+  for (size_t i = 0; i < states.size(); ++i) {
+    const std::vector<Int_t>& epsilon = fStates[states[i]].fEpsilon;
+    for (size_t j = 0; j < epsilon.size(); ++j) {
+      if (seen[epsilon[j]]) continue;
+      seen[epsilon[j]] = kTRUE;
+      states.push_back(epsilon[j]);
+    }
+  }
+  std::sort(states.begin(), states.end());
+  states.erase(std::unique(states.begin(), states.end()), states.end());
+
+  std::map<std::vector<Int_t>, Int_t>::const_iterator it =
+      fDStateIds.find(states);
+  if (it != fDStateIds.end()) return it->second;
+
+  Int_t best = -1;
+  for (size_t i = 0; i < states.size(); ++i) {
+    Int_t accept = fStates[states[i]].fAccept;
+    if (accept >= 0 && (best < 0 || fRanks[accept] < fRanks[best]))
+      best = accept;
+  }
+
+  Int_t id = fDStates.size();
+  fDStateIds[states] = id;
+  fDStates.push_back(states);
+  fDAccept.push_back(best);
+  fTransitions.insert(fTransitions.end(), 256, -2);
+  return id;
+}
+
+Int_t CmdLineGlob::Step(Int_t dstate, UChar_t c) {
+  std::vector<Int_t> next;
+  const std::vector<Int_t>& states = fDStates[dstate];
+  for (size_t i = 0; i < states.size(); ++i) {
+    const State& state = fStates[states[i]];
+    if (state.fSet >= 0 && fSets[state.fSet][c]) next.push_back(state.fNext);
+  }
+
+  Int_t id = next.empty() ? -1 : AddDState(next);
+  fTransitions[dstate * 256 + c] = id;
+  return id;
+}
+
+const char* CmdLineGlob::Match(const char* name) {
+  if (fPatterns.empty()) return nullptr;
+
+  if (fDStates.size() > gMaxDStates) {
+    // made for earlier names, the first state is kept
+    std::vector<Int_t> initial = fDStates[0];
+    fDStateIds.clear();
+    fDStates.clear();
+    fDAccept.clear();
+    fTransitions.clear();
+    AddDState(initial);
+  }
+
+  Int_t dstate = 0;
+  for (const UChar_t* c = (const UChar_t*)name; *c; ++c) {
+    Int_t next = fTransitions[dstate * 256 + *c];
+    if (next == -2) next = Step(dstate, *c);
+    if (next < 0) return nullptr;
+    dstate = next;
+  }
+  Int_t best = fDAccept[dstate];
+  return best < 0 ? nullptr : fPatterns[best].Data();
+}
@@ -0,0 +1,111 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineGlob.hh
+  \brief  Patterns of rc keys matched by one automaton
+
+  Keys of the rc files may be patterns:
+
+    *         any characters except '.', as a whole component one component
+    **        any characters, also several components
+    ?         one character except '.'
+    [abc]     one of the characters, [a-z] ranges, [!a-z] negation
+    [0-63]    decimal number in the range, [00-63] with fixed width
+    {A,B*}    one of the alternatives, which may be patterns
+
+  A bare '*' as the first or last component is ignored, as it always was.
+  All patterns are compiled into one automaton; a name is matched in one
+  pass over its characters, states are made when first needed.
+
+  If several patterns match, the most specific one wins. Components are
+  compared from the left, the first which differs decides: a literal beats
+  a component with wildcards, which beats '*', which beats '**'. Then the
+  pattern with more literal characters wins, and then the one given first
+  to Compile().
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINEGLOB_HH
+#define _CMDLINEGLOB_HH
+
+#include <bitset>
+#include <map>
+#include <vector>
+
+#include <TString.h>
+
+class CmdLineGlob {
+public:
+  CmdLineGlob();
+  virtual ~CmdLineGlob() {}
+
+  /// Whether the key has any wildcards.
+  static Bool_t IsPattern(const char* key);
+
+  /// Replaces the patterns, earlier ones win ties. Invalid patterns are
+  /// reported and skipped.
+  void Compile(const std::vector<TString>& patterns);
+  void Clear();
+  /// The most specific pattern matching the name, nullptr if none.
+  const char* Match(const char* name);
+  size_t GetNPatterns() const { return fPatterns.size(); }
+
+private:
+  CmdLineGlob(const CmdLineGlob&) = delete;
+  CmdLineGlob& operator=(const CmdLineGlob&) = delete;
+
+  typedef std::bitset<256> CharSet;
+
+  struct State {
+    Int_t fSet;  // index of the characters leading to fNext, -1 if none
+    Int_t fNext;
+    std::vector<Int_t> fEpsilon; // states reached without a character
+    Int_t fAccept;               // pattern matched, -1 if none
+  };
+
+  struct Specificity {
+    std::vector<Int_t> fKinds; // kind of every component, see Specific()
+    Int_t fLiterals;
+    Int_t fIndex;
+  };
+
+  static Bool_t Specific(const Specificity& a, const Specificity& b);
+  static Specificity Rank(const TString& pattern, Int_t index);
+
+  Int_t NewState();
+  Int_t AddTransition(Int_t from, const CharSet& set);
+  Int_t Parse(const char*& p, Int_t tail, Bool_t alternative);
+  Int_t ParseClass(const char*& p, Int_t tail);
+  Int_t ParseRange(const TString& lo, const TString& hi, Int_t tail);
+
+  Int_t AddDState(std::vector<Int_t>& states);
+  Int_t Step(Int_t dstate, UChar_t c);
+
+  std::vector<TString> fPatterns;
+  std::vector<Int_t> fRanks; // position of the patterns, 0 most specific
+  std::vector<State> fStates;
+  std::vector<CharSet> fSets;
+
+  // states of the automaton, made from sets of fStates when first reached
+  std::map<std::vector<Int_t>, Int_t> fDStateIds;
+  std::vector<std::vector<Int_t>> fDStates;
+  std::vector<Int_t> fDAccept;     // best pattern of the states, -1 if none
+  std::vector<Int_t> fTransitions; // 256 per state, -2 if not made yet
+};
+
+#endif
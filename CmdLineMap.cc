@@ -0,0 +1,195 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineMap.cc
+  \brief
+
+  The .npy header is a Python dict literal; only the keys 'descr',
+  'fortran_order' and 'shape' are read, arrays of more dimensions are seen
+  flattened in C order.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CmdLineMap.hh"
+
+static std::mutex gMapsMutex;
+static std::map<TString, std::weak_ptr<CmdLineMap>> gMaps;
+
+std::shared_ptr<CmdLineMap> CmdLineMap::Open(const char* path) {
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    std::cerr << "CmdLineMap: cannot open " << path << std::endl;
+    return nullptr;
+  }
+
+  std::lock_guard<std::mutex> lock(gMapsMutex);
+  std::shared_ptr<CmdLineMap> map = gMaps[path].lock();
+  if (map && map->fInode == (ULong64_t)st.st_ino &&
+      map->fMTime == (Long64_t)st.st_mtime &&
+      map->fLength == (size_t)st.st_size)
+    return map;
+
+  // a changed file is mapped again, users of the old mapping keep it
+  map.reset(new CmdLineMap(path));
+  if (!map->Map()) return nullptr;
+  gMaps[path] = map;
+  return map;
+}
+
+CmdLineMap::CmdLineMap(const char* path)
+    : fPath(path), fType(kNone), fMapping(nullptr), fLength(0),
+      fData(nullptr), fSize(0), fMTime(0), fInode(0) {}
+
+CmdLineMap::~CmdLineMap() {
+  if (fMapping) munmap(fMapping, fLength);
+}
+
+Bool_t CmdLineMap::Map() {
+  int fd = open(fPath, O_RDONLY);
+  struct stat st;
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    std::cerr << "CmdLineMap: cannot open " << fPath << std::endl;
+    if (fd >= 0) close(fd);
+    return kFALSE;
+  }
+  fInode = st.st_ino;
+  fMTime = st.st_mtime;
+  fLength = st.st_size;
+
+  if (fLength) {
+    void* p = mmap(nullptr, fLength, PROT_READ, MAP_SHARED, fd, 0);
+    if (p != MAP_FAILED) fMapping = p;
+  }
+  close(fd);
+  if (fLength && !fMapping) {
+    std::cerr << "CmdLineMap: cannot map " << fPath << std::endl;
+    return kFALSE;
+  }
+
+  size_t offset = 0;
+  Bool_t npy = fPath.EndsWith(".npy");
+  if (npy) {
+    if (!ReadNpyHeader(offset)) {
+      std::cerr << "CmdLineMap: unsupported .npy header in " << fPath
+                << std::endl;
+      return kFALSE;
+    }
+  } else if (fPath.EndsWith(".i32")) {
+    fType = kInt32;
+  } else if (fPath.EndsWith(".f64")) {
+    fType = kFloat64;
+  } else {
+    std::cerr << "CmdLineMap: unknown format of " << fPath
+              << ", expected .i32, .f64 or .npy" << std::endl;
+    return kFALSE;
+  }
+  size_t element = fType == kInt32 ? sizeof(Int_t) : sizeof(Double_t);
+
+  // raw files hold the elements only, .npy may be followed by padding
+  size_t bytes = fLength - offset;
+  if (!npy) fSize = bytes / element;
+  if (bytes < fSize * element || (!npy && bytes % element)) {
+    std::cerr << "CmdLineMap: truncated data in " << fPath << std::endl;
+    return kFALSE;
+  }
+  if (offset % element) {
+    std::cerr << "CmdLineMap: misaligned data in " << fPath << std::endl;
+    return kFALSE;
+  }
+  fData = (const char*)fMapping + offset;
+  return kTRUE;
+}
+
+Bool_t CmdLineMap::ReadNpyHeader(size_t& offset) {
+  // magic, version, header length (2 bytes in version 1, 4 bytes since)
+  const unsigned char* p = (const unsigned char*)fMapping;
+  if (fLength < 10 || memcmp(p, "\x93NUMPY", 6) != 0) return kFALSE;
+  size_t length;
+  if (p[6] == 1) {
+    length = p[8] | (p[9] << 8);
+    offset = 10;
+  } else {
+    if (fLength < 12) return kFALSE;
+    length = p[8] | (p[9] << 8) | (p[10] << 16) | ((size_t)p[11] << 24);
+    offset = 12;
+  }
+  if (offset + length > fLength) return kFALSE;
+  std::string header((const char*)p + offset, length);
+  offset += length;
+
+  // data are read in the byte order of the host
+  const UShort_t one = 1;
+  const char order = *(const char*)&one ? '<' : '>';
+
+  size_t pos = header.find("'descr'");
+  if (pos == std::string::npos) return kFALSE;
+  pos = header.find('\'', pos + 7);
+  size_t end = header.find('\'', pos + 1);
+  if (pos == std::string::npos || end == std::string::npos) return kFALSE;
+  std::string descr = header.substr(pos + 1, end - pos - 1);
+  if (descr.size() == 3 && (descr[0] == order || descr[0] == '=')) {
+    if (descr.compare(1, 2, "i4") == 0) fType = kInt32;
+    if (descr.compare(1, 2, "f8") == 0) fType = kFloat64;
+  }
+  if (fType == kNone) return kFALSE;
+
+  // numpy writes exactly this form
+  if (header.find("'fortran_order': True") != std::string::npos)
+    return kFALSE;
+
+  pos = header.find("'shape'");
+  if (pos == std::string::npos) return kFALSE;
+  pos = header.find('(', pos);
+  end = header.find(')', pos);
+  if (pos == std::string::npos || end == std::string::npos) return kFALSE;
+  fSize = 1;
+  const char* cp = header.c_str() + pos + 1;
+  while (cp < header.c_str() + end) {
+    char* next;
+    unsigned long long n = strtoull(cp, &next, 10);
+    if (next == cp) {
+      ++cp;
+      continue;
+    }
+    fSize *= n;
+    cp = next;
+  }
+  return kTRUE;
+}
+
+CmdLineSpan<Int_t> CmdLineMap::GetInts() const {
+  if (fType != kInt32) return CmdLineSpan<Int_t>();
+  return CmdLineSpan<Int_t>((const Int_t*)fData, fSize);
+}
+
+CmdLineSpan<Double_t> CmdLineMap::GetDoubles() const {
+  if (fType != kFloat64) return CmdLineSpan<Double_t>();
+  return CmdLineSpan<Double_t>((const Double_t*)fData, fSize);
+}
@@ -0,0 +1,89 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineMap.hh
+  \brief  Array values stored in binary files
+
+  An int or double option with the value "@file" takes its elements from the
+  file, which is mapped read-only and shared by all contexts and processes
+  using it. Raw files are recognized by the extension (.i32 for int, .f64
+  for double options), .npy files by their header.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINEMAP_HH
+#define _CMDLINEMAP_HH
+
+#include <memory>
+
+#include <TString.h>
+
+/// View of the elements of an array value, does not own them.
+template <typename T> class CmdLineSpan {
+public:
+  CmdLineSpan() : fData(nullptr), fSize(0) {}
+  CmdLineSpan(const T* data, size_t size) : fData(data), fSize(size) {}
+
+  const T* data() const { return fData; }
+  size_t size() const { return fSize; }
+  Bool_t empty() const { return fSize == 0; }
+  const T* begin() const { return fData; }
+  const T* end() const { return fData + fSize; }
+  const T& operator[](size_t i) const { return fData[i]; }
+
+private:
+  const T* fData;
+  size_t fSize;
+};
+
+class CmdLineMap {
+public:
+  enum DataType { kNone, kInt32, kFloat64 };
+
+  /// Maps the file, or returns the mapping already made by another option if
+  /// the file did not change since. Returns nullptr on errors.
+  static std::shared_ptr<CmdLineMap> Open(const char* path);
+
+  virtual ~CmdLineMap();
+
+  const TString& GetPath() const { return fPath; }
+  DataType GetType() const { return fType; }
+  size_t GetSize() const { return fSize; }
+
+  CmdLineSpan<Int_t> GetInts() const;
+  CmdLineSpan<Double_t> GetDoubles() const;
+
+private:
+  CmdLineMap(const char* path);
+  CmdLineMap(const CmdLineMap&) = delete;
+  CmdLineMap& operator=(const CmdLineMap&) = delete;
+
+  Bool_t Map();
+  Bool_t ReadNpyHeader(size_t& offset);
+
+  TString fPath;
+  DataType fType;
+  void* fMapping;     // whole file
+  size_t fLength;     // length of the file
+  const void* fData;  // first element
+  size_t fSize;       // number of elements
+  Long64_t fMTime;    // modification time and inode when mapped
+  ULong64_t fInode;
+};
+
+#endif
@@ -28,9 +28,15 @@
   \date   2019-03-01
 */
 
+#include <algorithm>
+#include <charconv>
+#include <cstdio>
 #include <cstdlib>
 #include <iomanip>
 #include <iostream>
+#include <functional>
+#include <mutex>
+#include <unordered_map>
 
 #include <TEnv.h>
 #include <THashList.h>
@@ -39,6 +45,7 @@
 #include <TObjString.h>
 #include <TSystem.h>
 
+#include "CmdLineBatch.hh"
 #include "CmdLineConfig.hh"
 #include "CmdLineOption.hh"
 
@@ -46,10 +53,55 @@ const TString CmdLineOption::delim = ": ,";
 
 Bool_t CmdLineOption::AbortOnWarning = kFALSE;
 
+// grows when options are destroyed, caches made before are dropped
+static std::atomic<ULong64_t> gExpandEpoch(0);
+
+struct ExpandKey {
+  const CmdLineOption* fTemplate;
+  const TObject* fObject;
+
+  bool operator==(const ExpandKey& key) const {
+    return fTemplate == key.fTemplate && fObject == key.fObject;
+  }
+};
+
+struct ExpandKeyHash {
+  size_t operator()(const ExpandKey& key) const {
+    std::hash<const void*> hash;
+    return hash(key.fTemplate) * 31 + hash(key.fObject);
+  }
+};
+
+struct ExpandEntry {
+  CmdLineConfig* fContext; // context the option was expanded in
+  TClass* fClass;      // class and name of the object when expanded
+  const char* fName;   // in the name of the option
+  size_t fLength;
+  CmdLineOption* fOption;
+};
+
+// Expansions of templates for objects. Every thread has its own, threads
+// expanding in event loops do not wait for each other.
+struct ExpandCache {
+  typedef std::unordered_map<ExpandKey, ExpandEntry, ExpandKeyHash> Entries;
+  ULong64_t fEpoch;
+  Entries fEntries;
+
+  ExpandCache() : fEpoch(0) {}
+};
+
+static thread_local ExpandCache gExpandCache;
+// transient objects would fill the cache, it starts again beyond this
+static const size_t gExpandCacheSize = 4096;
+
+// Expanded option destroyed by a delete expression of this thread, its
+// memory is released with the arena.
+static thread_local void* gArenaDeleted = nullptr;
+
 CmdLineOption::CmdLineOption(const char* name, const char* cmd,
                              const char* help, void (*f)()) {
   Init(name, cmd, help);
-  fDefInt = kFALSE;
+  fDef.fInt = kFALSE;
   fType = kFlag;
   fFunction = f;
 }
@@ -57,7 +109,7 @@ CmdLineOption::CmdLineOption(const char* name, const char* cmd,
 CmdLineOption::CmdLineOption(const char* name, const char* cmd,
                              const char* help, Bool_t defval, void (*f)()) {
   Init(name, cmd, help);
-  fDefInt = (defval == kTRUE ? 1 : 0);
+  fDef.fInt = (defval == kTRUE ? 1 : 0);
   fType = kBool;
   fFunction = f;
 }
@@ -65,7 +117,7 @@ CmdLineOption::CmdLineOption(const char* name, const char* cmd,
 CmdLineOption::CmdLineOption(const char* name, const char* cmd,
                              const char* help, Int_t defval, void (*f)()) {
   Init(name, cmd, help);
-  fDefInt = defval;
+  fDef.fInt = defval;
   fType = kInt;
   fFunction = f;
 }
@@ -73,7 +125,7 @@ CmdLineOption::CmdLineOption(const char* name, const char* cmd,
 CmdLineOption::CmdLineOption(const char* name, const char* cmd,
                              const char* help, Double_t defval, void (*f)()) {
   Init(name, cmd, help);
-  fDefDouble = defval;
+  fDef.fDouble = defval;
   fType = kDouble;
   fFunction = f;
 }
@@ -82,7 +134,8 @@ CmdLineOption::CmdLineOption(const char* name, const char* cmd,
                              const char* help, const char* defval,
                              void (*f)()) {
   Init(name, cmd, help);
-  fDefString = defval;
+  fDef.fString = defval && *defval && fConfig ? fConfig->fArena.Copy(defval)
+                                              : nullptr;
   fType = kStringNotChecked;
   fFunction = f;
 }
@@ -102,6 +155,17 @@ CmdLineOption::CmdLineOption(const char* name, Double_t defval)
 CmdLineOption::CmdLineOption(const char* name, const char* defval)
     : CmdLineOption(name, 0, 0, defval, nullptr) {}
 
+CmdLineOption::CmdLineOption(const CmdLineOption* tmpl, const char* name)
+    : fName(name), fType(tmpl->fType), fFunction(nullptr) {
+  fConfig = CmdLineConfig::Current();
+  fDef = tmpl->fDef;
+  // string defaults are shared within the context only
+  if ((fType == kString || fType == kStringNotChecked) && fDef.fString &&
+      tmpl->fConfig != fConfig)
+    fDef.fString = fConfig->fArena.Copy(fDef.fString);
+  SetBit(kExpanded);
+}
+
 CmdLineOption::CmdLineOption(const CmdLineOption& ref) {
   MayNotUse("CmdLineOption(const CmdLineOption& ref)");
 }
@@ -109,61 +173,209 @@ CmdLineOption::CmdLineOption(const CmdLineOption& ref) {
 CmdLineOption::CmdLineOption() { Init(0, 0, 0); };
 
 CmdLineOption::~CmdLineOption() {
-  TObject* obj =
-      CmdLineConfig::instance()->GetEnv()->Lookup("CmdLine." + fName);
-  if (obj) CmdLineConfig::instance()->GetEnv()->GetTable()->Remove(obj);
+  // cached expansions of and from the option are dropped in all threads
+  ++gExpandEpoch;
+  if (TestBit(kBound)) CmdLineBinding::Remove(this);
+  if (!fConfig) return;
+  // the context destroys its expanded options without fConfig
+  if (TestBit(kExpanded)) gArenaDeleted = this;
 
-  if (!fName.IsNull()) CmdLineConfig::instance()->Remove(this);
+  fConfig->Erase("CmdLine." + fName);
+  if (!fName.IsNull()) fConfig->Remove(this);
+}
+
+void CmdLineOption::operator delete(void* p) {
+  if (p == gArenaDeleted) {
+    gArenaDeleted = nullptr;
+    return;
+  }
+  TObject::operator delete(p);
 }
 
 CmdLineOption* CmdLineOption::Expand(TObject* obj) {
   if (obj == 0) return nullptr;
+  CmdLineConfig* cfg = CmdLineConfig::Current();
+  const char* name = obj->GetName();
+
+  ExpandCache& cache = gExpandCache;
+  ULong64_t epoch = gExpandEpoch;
+  if (cache.fEpoch != epoch) {
+    cache.fEntries.clear();
+    cache.fEpoch = epoch;
+  }
+
+  ExpandKey key = {this, obj};
+  ExpandCache::Entries::const_iterator it = cache.fEntries.find(key);
+  if (it != cache.fEntries.end()) {
+    const ExpandEntry& entry = it->second;
+    // the object may have been renamed, or replaced at the same address
+    if (entry.fContext == cfg && entry.fClass == obj->IsA() &&
+        strncmp(name, entry.fName, entry.fLength) == 0 &&
+        name[entry.fLength] == 0)
+      return entry.fOption;
+  }
+
   TString cname = obj->ClassName();
-  TString name = obj->GetName();
-  return Expand(cname, name);
+  CmdLineOption* opt = Expand(cname, name);
+  // options defined by the user may be deleted, they are not cached
+  if (!opt || !opt->TestBit(kExpanded)) return opt;
+
+  if (cache.fEntries.size() >= gExpandCacheSize) cache.fEntries.clear();
+  ExpandEntry entry;
+  entry.fContext = cfg;
+  entry.fClass = obj->IsA();
+  entry.fOption = opt;
+  entry.fName = opt->fName.Data() + cname.Length() + 1;
+  entry.fLength = strlen(name);
+  cache.fEntries[key] = entry;
+  return opt;
 }
 
 CmdLineOption* CmdLineOption::Expand(const TString& cname,
                                      const TString& name) {
+  if (fType == kNone) return nullptr;
   TString newname = cname + "." + name + "." + fName;
-  CmdLineOption* newopt = CmdLineConfig::instance()->FindOption(newname);
+  CmdLineConfig* cfg = CmdLineConfig::Current();
+  CmdLineOption* newopt = cfg->FindOption(newname);
   if (newopt != 0) return newopt;
-  switch (fType) {
-    case kFlag:
-      newopt = new CmdLineOption(newname, kFALSE);
-      break;
-    case kBool:
-      newopt = new CmdLineOption(newname, (Bool_t)fDefInt);
-      break;
-    case kInt:
-      newopt = new CmdLineOption(newname, fDefInt);
-      break;
-    case kDouble:
-      newopt = new CmdLineOption(newname, fDefDouble);
-      break;
-    case kString:
-    case kStringNotChecked:
-      newopt = new CmdLineOption(newname, fDefString);
-      break;
-    default:
-      newopt = 0;
-  }
+
+  void* p = cfg->fArena.Allocate(sizeof(CmdLineOption), alignof(CmdLineOption));
+  newopt = new (p) CmdLineOption(this, cfg->fArena.Copy(newname));
+  cfg->Insert(newopt);
   return newopt;
 }
 
+std::vector<CmdLineOption*>
+CmdLineOption::Expand(const std::vector<TObject*>& objects,
+                      const std::vector<CmdLineOption*>& templates,
+                      UInt_t nthreads) {
+  CmdLineConfig* cfg = CmdLineConfig::Current();
+  size_t ntemplates = templates.size();
+  std::vector<CmdLineOption*> result(objects.size() * ntemplates, nullptr);
+
+  // keys "CmdLine.Class.Object.Name" of all options in one buffer, only
+  // those of new options are copied into the arena
+  std::vector<const char*> cnames(objects.size()), names(objects.size());
+  size_t length = 0, suffixes = 0;
+  for (size_t t = 0; t < ntemplates; ++t)
+    suffixes += templates[t]->fName.Length() + 1;
+  for (size_t o = 0; o < objects.size(); ++o) {
+    if (!objects[o]) continue;
+    cnames[o] = objects[o]->ClassName();
+    names[o] = objects[o]->GetName();
+    length += (strlen(cnames[o]) + strlen(names[o]) + 10) * ntemplates;
+    length += suffixes;
+  }
+  std::vector<char> buffer(length);
+
+  std::vector<const char*> keys(result.size(), nullptr);
+  std::vector<size_t> missing;
+  char* cp = buffer.data();
+  for (size_t o = 0; o < objects.size(); ++o) {
+    if (!objects[o]) continue;
+    for (size_t t = 0; t < ntemplates; ++t) {
+      if (templates[t]->fType == kNone) continue;
+      size_t i = o * ntemplates + t;
+      keys[i] = cp;
+      cp += sprintf(cp, "CmdLine.%s.%s.%s", cnames[o], names[o],
+                    templates[t]->fName.Data()) + 1;
+      result[i] = cfg->FindOption(keys[i] + 8);
+      if (!result[i]) missing.push_back(i);
+    }
+  }
+
+  // the same name may be requested more than once
+  std::sort(missing.begin(), missing.end(), [&](size_t a, size_t b) {
+    return strcmp(keys[a], keys[b]) < 0;
+  });
+  size_t nnew = 0;
+  for (size_t m = 0; m < missing.size(); ++m)
+    if (!m || strcmp(keys[missing[m - 1]], keys[missing[m]]) != 0) ++nnew;
+
+  CmdLineOption* block = (CmdLineOption*)cfg->fArena.Allocate(
+      nnew * sizeof(CmdLineOption), alignof(CmdLineOption));
+  std::vector<CmdLineOption*> created;
+  std::vector<const char*> createdKeys;
+  for (size_t m = 0; m < missing.size(); ++m) {
+    size_t i = missing[m];
+    if (m && strcmp(keys[missing[m - 1]], keys[i]) == 0) {
+      result[i] = result[missing[m - 1]];
+      continue;
+    }
+    const char* key = cfg->fArena.Copy(keys[i]);
+    result[i] = new (block + created.size())
+        CmdLineOption(templates[i % ntemplates], key + 8);
+    created.push_back(result[i]);
+    createdKeys.push_back(key);
+  }
+  cfg->Insert(created);
+
+  // the lookups share the caches of the context and are made here, the
+  // threads only convert the values
+  std::vector<TEnvRec*> found(created.size(), nullptr);
+  {
+    CmdLineConfig::Scope scope(cfg);
+    for (size_t i = 0; i < created.size(); ++i)
+      found[i] = created[i]->Findvalue(createdKeys[i]);
+  }
+  ULong64_t stamp = cfg->GetGeneration();
+  std::vector<CmdLineValue> values(created.size());
+  std::vector<char> ok(created.size());
+  CmdLineBatch::ParallelFor(created.size(), nthreads, [&](size_t i) {
+    ok[i] = created[i]->Convert(found[i] ? found[i]->GetValue() : nullptr,
+                                values[i]);
+    values[i].fStamp = stamp;
+  });
+
+  // malformed values are reported like those of single options
+  std::lock_guard<std::mutex> lock(cfg->fValuesMutex);
+  for (size_t i = 0; i < created.size(); ++i) {
+    cfg->Report(created[i], ok[i], found[i], nullptr);
+    cfg->fValues[created[i]] = std::move(values[i]);
+  }
+  return result;
+}
+
+std::vector<CmdLineOption*>
+CmdLineOption::Expand(const TCollection* objects,
+                      const std::vector<CmdLineOption*>& templates,
+                      UInt_t nthreads) {
+  std::vector<TObject*> list;
+  TIter it(objects);
+  TObject* obj;
+  while ((obj = it.Next()))
+    list.push_back(obj);
+  return Expand(list, templates, nthreads);
+}
+
 void CmdLineOption::Init(const char* name, const char* cmd, const char* help) {
-  if (0 == strlen(name)) return;
-
-  fName = name;
-  fCmdArg = cmd;
-  fHelp = help;
-  fDefInt = 0;
-  fDefDouble = 0.;
-  fDefString = "";
+  fConfig = nullptr;
+  if (!name || 0 == strlen(name)) return;
+
+  fConfig = CmdLineConfig::Current();
+  // no storage taken by the empty tags and help texts of expanded options
+  fName = CmdLineName(fConfig->fArena.Copy(name));
+  fCmdArg = CmdLineName(cmd && *cmd ? fConfig->fArena.Copy(cmd) : nullptr);
+  fHelp = CmdLineName(help && *help ? fConfig->fArena.Copy(help) : nullptr);
+  fDef.fDouble = 0.;
   fType = kNone;
   fFunction = 0;
 
-  CmdLineConfig::instance()->Insert(this);
+  fConfig->Insert(this);
+}
+
+Int_t CmdLineOption::GetDefInt() const {
+  if (fType == kFlag || fType == kBool || fType == kInt) return fDef.fInt;
+  return 0;
+}
+
+Double_t CmdLineOption::GetDefDouble() const {
+  return fType == kDouble ? fDef.fDouble : 0.;
+}
+
+const char* CmdLineOption::GetDefString() const {
+  if (fType == kString || fType == kStringNotChecked) return fDef.fString;
+  return nullptr;
 }
 
 const Int_t CmdLineOption::GetArraySizeFromString(const TString arraystring) {
@@ -203,86 +415,139 @@ CmdLineOption::GetDoubleArrayValueFromString(const TString arraystring,
 
 const char* CmdLineOption::GetHelp() const { return fHelp.Data(); };
 
+CmdLineBinding CmdLineOption::AddBinding(const CmdLineBinding::Writer& writer) {
+  SetBit(kBound);
+  return CmdLineBinding::Add(CmdLineConfig::Current(), this, writer);
+}
+
+Double_t CmdLineOption::GetBoundNumber() {
+  switch (fType) {
+    case kFlag:
+    case kBool:
+    case kInt:
+      return CmdLineConfig::Current()->GetTypedValue(this).fInt;
+    case kDouble:
+      return CmdLineConfig::Current()->GetTypedValue(this).fDouble;
+    default:
+      return TString(GetBoundText()).Atof();
+  }
+}
+
+const char* CmdLineOption::GetBoundText() {
+  const char* cp = GetValue("CmdLine." + fName, GetDefString());
+  return cp ? cp : "";
+}
+
 const Bool_t CmdLineOption::GetFlagValue() const {
-  if (fType != kFlag)
+  if (fType != kFlag) {
     std::cerr << "CmdLineOption: " << fName << " not defined as flag! "
               << std::endl;
-  if (GetValue("CmdLine." + fName, kFALSE) == 1) return kTRUE;
-  return kFALSE;
+    if (GetValue("CmdLine." + fName, kFALSE) == 1) return kTRUE;
+    return kFALSE;
+  }
+  return CmdLineConfig::Current()->GetTypedValue(this).fInt == 1;
 }
 
 const Bool_t CmdLineOption::GetBoolValue() const {
-  if (fType != kBool)
+  if (fType != kBool) {
     std::cerr << "CmdLineOption: " << fName << " not defined as bool! "
               << std::endl;
-  if (GetValue("CmdLine." + fName, fDefInt) == 1) return kTRUE;
-  return kFALSE;
+    if (GetValue("CmdLine." + fName, GetDefInt()) == 1) return kTRUE;
+    return kFALSE;
+  }
+  return CmdLineConfig::Current()->GetTypedValue(this).fInt == 1;
 }
 
 const Int_t CmdLineOption::GetIntValue() const {
-  if (fType != kInt)
+  if (fType != kInt) {
     std::cerr << "CmdLineOption: " << fName << " not defined as integer!"
               << std::endl;
-  return GetValue("CmdLine." + fName, fDefInt);
+    return GetValue("CmdLine." + fName, GetDefInt());
+  }
+  return CmdLineConfig::Current()->GetTypedValue(this).fInt;
 }
 
 const Int_t CmdLineOption::GetIntArrayValue(const Int_t index) {
+  if (fType == kInt) {
+    CmdLineSpan<Int_t> values = GetIntArray();
+    if (index >= 1 && index <= (Int_t)values.size()) return values[index - 1];
+    return 0;
+  }
   const TString arraystring = GetStringValue(kTRUE);
   return GetIntArrayValueFromString(arraystring, index);
 }
 
 const Double_t CmdLineOption::GetDoubleValue() const {
-  if (fType != kDouble)
+  if (fType != kDouble) {
     std::cerr << "CmdLineOption: " << fName << " not defined as double!"
               << std::endl;
-  return GetValue("CmdLine." + fName, fDefDouble);
+    return GetValue("CmdLine." + fName, GetDefDouble());
+  }
+  return CmdLineConfig::Current()->GetTypedValue(this).fDouble;
 }
 
 const Double_t CmdLineOption::GetDoubleArrayValue(const Int_t index) {
+  if (fType == kDouble) {
+    CmdLineSpan<Double_t> values = GetDoubleArray();
+    if (index >= 1 && index <= (Int_t)values.size()) return values[index - 1];
+    return 0.;
+  }
   const TString arraystring = GetStringValue(kTRUE);
   return GetDoubleArrayValueFromString(arraystring, index);
 }
 
 const Int_t CmdLineOption::GetArraySize() {
+  if (fType == kInt) return GetIntArray().size();
+  if (fType == kDouble) return GetDoubleArray().size();
   const TString arraystring = GetStringValue(kTRUE);
   return GetArraySizeFromString(arraystring);
 }
 
-const char* CmdLineOption::GetStringValue(Bool_t arrayParsing) {
-  if (fType == kStringNotChecked) {
-    const char* envVal = CmdLineConfig::instance()->GetEnv()->GetValue(
-        "CmdLine." + fName, (const char*)0);
-    if (envVal != 0) {
-      TString tmpString = envVal;
-      TString corString = tmpString.Strip();
-      CmdLineConfig::instance()->GetEnv()->SetValue("CmdLine." + fName,
-                                                    corString.Data());
-    }
-    fType = kString;
+CmdLineSpan<Int_t> CmdLineOption::GetIntArray() const {
+  if (fType != kInt) {
+    std::cerr << "CmdLineOption: " << fName << " not defined as integer!"
+              << std::endl;
+    return CmdLineSpan<Int_t>();
+  }
+  return CmdLineConfig::Current()->GetTypedValue(this).GetInts();
+}
+
+CmdLineSpan<Double_t> CmdLineOption::GetDoubleArray() const {
+  if (fType != kDouble) {
+    std::cerr << "CmdLineOption: " << fName << " not defined as double!"
+              << std::endl;
+    return CmdLineSpan<Double_t>();
   }
-  if (!arrayParsing and fType != kString) {
+  return CmdLineConfig::Current()->GetTypedValue(this).GetDoubles();
+}
+
+const char* CmdLineOption::GetStringValue(Bool_t arrayParsing) {
+  if (!arrayParsing and fType != kString && fType != kStringNotChecked) {
     std::cerr << "CmdLineOption: " << fName << " not defined as char*!"
               << std::endl;
     if (AbortOnWarning) abort();
   }
-  if (fDefString.IsNull())
-    return GetValue("CmdLine." + fName, (const char*)0);
-  else
-    return GetValue("CmdLine." + fName, fDefString.Data());
+  const char* value = GetValue("CmdLine." + fName, GetDefString());
+  // trailing blanks of values are not part of strings, the stripped copy is
+  // kept with the converted value
+  size_t len = value ? strlen(value) : 0;
+  if (fType == kStringNotChecked && len && isspace((int)value[len - 1]))
+    return CmdLineConfig::Current()->GetTypedValue(this).fString.Data();
+  return value;
 }
 
 const Bool_t CmdLineOption::GetDefaultBoolValue() const {
   if (fType != kBool)
     std::cerr << "CmdLineOption: " << fName << " not defined as bool! "
               << std::endl;
-  return (Bool_t)fDefInt;
+  return (Bool_t)GetDefInt();
 }
 
 const Int_t CmdLineOption::GetDefaultIntValue() const {
   if (fType != kInt)
     std::cerr << "CmdLineOption: " << fName << " not defined as integer!"
               << std::endl;
-  return fDefInt;
+  return GetDefInt();
 }
 
 const Int_t CmdLineOption::GetDefaultIntArrayValue(const Int_t index) const {
@@ -294,7 +559,7 @@ const Double_t CmdLineOption::GetDefaultDoubleValue() const {
   if (fType != kDouble)
     std::cerr << "CmdLineOption: " << fName << " not defined as double!"
               << std::endl;
-  return fDefDouble;
+  return GetDefDouble();
 }
 
 const Double_t
@@ -312,102 +577,111 @@ const char* CmdLineOption::GetDefaultStringValue(Bool_t arrayparsing) const {
   if (!arrayparsing and fType != kString && fType != kStringNotChecked)
     std::cerr << "CmdLineOption: " << fName << " not defined as char*!"
               << std::endl;
-  if (fDefString.IsNull())
-    return (const char*)nullptr;
-  else
-    return fDefString.Data();
+  return GetDefString();
 }
 
 const Bool_t CmdLineOption::GetFlagValue(const char* name) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetFlagValue();
   return kFALSE;
 }
 
 const Bool_t CmdLineOption::GetBoolValue(const char* name) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetBoolValue();
   return kFALSE;
 }
 
 const Int_t CmdLineOption::GetIntValue(const char* name) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetIntValue();
   return 0;
 }
 
 const Int_t CmdLineOption::GetIntArrayValue(const char* name,
                                             const Int_t index) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetIntArrayValue(index);
   return 0;
 }
 
 const Double_t CmdLineOption::GetDoubleValue(const char* name) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetDoubleValue();
   return 0.;
 }
 
 const Double_t CmdLineOption::GetDoubleArrayValue(const char* name,
                                                   const Int_t index) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetDoubleArrayValue(index);
   return 0;
 }
 
 const Int_t CmdLineOption::GetArraySize(const char* name) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetArraySize();
   return 0;
 }
 
 const char* CmdLineOption::GetStringValue(const char* name) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetStringValue();
   return nullptr;
 }
 
+CmdLineSpan<Int_t> CmdLineOption::GetIntArray(const char* name) {
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
+  if (entry) return entry->GetIntArray();
+  return CmdLineSpan<Int_t>();
+}
+
+CmdLineSpan<Double_t> CmdLineOption::GetDoubleArray(const char* name) {
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
+  if (entry) return entry->GetDoubleArray();
+  return CmdLineSpan<Double_t>();
+}
+
 const Bool_t CmdLineOption::GetDefaultBoolValue(const char* name) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry->fName == name) return entry->GetDefaultBoolValue();
   return kFALSE;
 }
 
 const Int_t CmdLineOption::GetDefaultIntValue(const char* name) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetDefaultIntValue();
   return 0;
 }
 
 const Int_t CmdLineOption::GetDefaultIntArrayValue(const char* name,
                                                    const Int_t index) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetDefaultIntArrayValue(index);
   return 0;
 }
 
 const Double_t CmdLineOption::GetDefaultDoubleValue(const char* name) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetDefaultDoubleValue();
   return 0.;
 }
 
 const Double_t CmdLineOption::GetDefaultDoubleArrayValue(const char* name,
                                                          const Int_t index) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetDefaultDoubleArrayValue(index);
   return 0;
 }
 
 const Int_t CmdLineOption::GetDefaultArraySize(const char* name) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetDefaultArraySize();
   return 0;
 }
 
 const char* CmdLineOption::GetDefaultStringValue(const char* name) {
-  CmdLineOption* entry = CmdLineConfig::instance()->FindOption(name);
+  CmdLineOption* entry = CmdLineConfig::Current()->FindOption(name);
   if (entry) return entry->GetDefaultStringValue();
   return nullptr;
 }
@@ -480,41 +754,21 @@ void CmdLineOption::Print() {
 }
 
 const char* CmdLineOption::Getvalue(const char* name) const {
-  TEnvRec* tmp = CmdLineConfig::instance()->GetEnv()->Lookup(name);
-  if (tmp != 0) return tmp->GetValue();
-
-  // ok, let's try to match wildcards: everything may be replaced by '*'
-  // except the first and last component
-
-  TString searchname = name;
-  TObjArray* components = searchname.Tokenize(".");
-  Int_t n = components->GetEntries();
-  Int_t max_count = 1 << (n - 1);
-  Int_t count = 2;
-  while (count < max_count) {
-    TString to_be_checked = "";
-    for (Int_t i = 0; i < n; i++) {
-      if (to_be_checked > "") to_be_checked += ".";
-      if (count & (1 << (n - i - 1))) {
-        to_be_checked += "*";
-      } else {
-        to_be_checked +=
-            dynamic_cast<TObjString*>(components->At(i))->GetString();
-      }
-    }
-    // std::cout << "Searching " << to_be_checked << std::endl;
-    tmp = CmdLineConfig::instance()->GetEnv()->Lookup(to_be_checked);
-    if (tmp) {
-      // std::cout << "Found." << std::endl;
-      delete components;
-      return tmp->GetValue();
-    }
-    count += 2;
-  }
-  delete components;
+  TEnvRec* rec = Findvalue(name);
+  // built-in defaults are below all patterns of the rc files
+  if (!rec) rec = CmdLineConfig::Current()->LookupDefault(name);
+  if (rec) return rec->GetValue();
   return nullptr;
 }
 
+TEnvRec* CmdLineOption::Findvalue(const char* name) const {
+  TEnvRec* tmp = CmdLineConfig::Current()->Lookup(name);
+  if (tmp != 0) return tmp;
+
+  // ok, let's try to match patterns, see CmdLineGlob
+  return CmdLineConfig::Current()->LookupPattern(name);
+}
+
 // code taken from TEnv functions
 
 static struct BoolNameTable_t {
@@ -523,6 +777,120 @@ static struct BoolNameTable_t {
 } gBoolNames[] = {{"TRUE", 1}, {"FALSE", 0}, {"ON", 1},  {"OFF", 0}, {"YES", 1},
                   {"NO", 0},   {"OK", 1},    {"NOT", 0}, {0, 0}};
 
+static Bool_t ParseInt(const char* begin, const char* end, Int_t& value) {
+  if (begin != end && *begin == '+') ++begin;
+  std::from_chars_result res = std::from_chars(begin, end, value);
+  return res.ec == std::errc() && res.ptr == end;
+}
+
+static Bool_t ParseBool(const char* begin, const char* end, Int_t& value) {
+  if (ParseInt(begin, end, value)) return kTRUE;
+
+  for (BoolNameTable_t* bt = gBoolNames; bt->fName; bt++) {
+    if (strlen(bt->fName) == (size_t)(end - begin) &&
+        strncasecmp(bt->fName, begin, end - begin) == 0) {
+      value = bt->fValue;
+      return kTRUE;
+    }
+  }
+  return kFALSE;
+}
+
+static Bool_t ParseDouble(const char* begin, const char* end, Double_t& value) {
+  if (begin != end && *begin == '+') ++begin;
+  std::from_chars_result res = std::from_chars(begin, end, value);
+  return res.ec == std::errc() && res.ptr == end;
+}
+
+//______________________________________________________________________________
+Bool_t CmdLineOption::ParseValue(const char* value, OptionType type,
+                                 std::vector<Int_t>& ints,
+                                 std::vector<Double_t>& doubles) {
+  ints.clear();
+  doubles.clear();
+
+  Bool_t ok = kTRUE;
+  const char* cp = value ? value : "";
+  while (*cp && ok) {
+    while (*cp && strchr(delim.Data(), *cp))
+      cp++;
+    if (!*cp) break;
+    const char* end = cp;
+    while (*end && !strchr(delim.Data(), *end))
+      end++;
+
+    Int_t i;
+    Double_t d;
+    switch (type) {
+      case kFlag:
+      case kBool:
+        ok = ParseBool(cp, end, i);
+        if (ok) ints.push_back(i);
+        break;
+      case kInt:
+        ok = ParseInt(cp, end, i);
+        if (ok) ints.push_back(i);
+        break;
+      case kDouble:
+        ok = ParseDouble(cp, end, d);
+        if (ok) doubles.push_back(d);
+        break;
+      default:
+        break;
+    }
+    cp = end;
+  }
+
+  if (!ok) {
+    ints.clear();
+    doubles.clear();
+  }
+  return ok;
+}
+
+//______________________________________________________________________________
+Bool_t CmdLineOption::Convert(const char* value, CmdLineValue& result) const {
+  // Converts all elements of the value to the type of the option. If any
+  // element is malformed, the default value is used and kFALSE is returned.
+  // Values "@file" of int and double options refer to binary files.
+
+  const char* cp = value;
+  while (cp && isspace((int)*cp))
+    cp++;
+
+  Bool_t ok;
+  result.fMap.reset();
+  if (fType == kString || fType == kStringNotChecked) {
+    result.fString = value ? value : GetDefString();
+    result.fString = result.fString.Strip();
+  }
+  if ((fType == kInt || fType == kDouble) && cp && *cp == '@') {
+    result.fInts.clear();
+    result.fDoubles.clear();
+    result.fMap = CmdLineMap::Open(TString(cp + 1).Strip(TString::kTrailing));
+    CmdLineMap::DataType type =
+        fType == kInt ? CmdLineMap::kInt32 : CmdLineMap::kFloat64;
+    if (result.fMap && result.fMap->GetType() != type) {
+      std::cerr << "CmdLineOption: " << result.fMap->GetPath()
+                << " does not hold " << (fType == kInt ? "int" : "double")
+                << " elements for " << fName << std::endl;
+      result.fMap.reset();
+    }
+    ok = result.fMap != nullptr;
+  } else {
+    ok = ParseValue(value, fType, result.fInts, result.fDoubles);
+  }
+
+  result.fInt = fType == kFlag ? kFALSE : GetDefInt();
+  result.fDouble = GetDefDouble();
+  CmdLineSpan<Int_t> ints = result.GetInts();
+  CmdLineSpan<Double_t> doubles = result.GetDoubles();
+  if (ints.size()) result.fInt = ints[0];
+  if (doubles.size()) result.fDouble = doubles[0];
+
+  return ok;
+}
+
 //______________________________________________________________________________
 Int_t CmdLineOption::GetValue(const char* name, Int_t dflt) const {
   // Returns the integer value for a resource. If the resource is not found
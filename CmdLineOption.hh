@@ -33,10 +33,38 @@
 #include "TObject.h"
 #include "TString.h"
 
+#include <memory>
 #include <vector>
 
+#include "CmdLineArena.hh"
+#include "CmdLineBinding.hh"
+#include "CmdLineMap.hh"
+
+class TCollection;
 class TList;
 class TEnv;
+class TEnvRec;
+class CmdLineConfig;
+
+/// Value of an option converted to its declared type.
+struct CmdLineValue {
+  ULong64_t fStamp; // configuration state the value was converted in
+  Int_t fInt;       // flag, bool and int options
+  Double_t fDouble; // double options
+  std::vector<Int_t> fInts;       // all elements of int arrays
+  std::vector<Double_t> fDoubles; // all elements of double arrays
+  std::shared_ptr<CmdLineMap> fMap; // file of an "@file" value
+  TString fString;                  // string options, trailing blanks stripped
+
+  CmdLineSpan<Int_t> GetInts() const {
+    if (fMap) return fMap->GetInts();
+    return CmdLineSpan<Int_t>(fInts.data(), fInts.size());
+  }
+  CmdLineSpan<Double_t> GetDoubles() const {
+    if (fMap) return fMap->GetDoubles();
+    return CmdLineSpan<Double_t>(fDoubles.data(), fDoubles.size());
+  }
+};
 
 class CmdLineOption : public TObject {
 public:
@@ -63,12 +91,47 @@ public:
                 const char* defval, void (*f)() = 0);
 
   virtual ~CmdLineOption();
-
+  /// Memory of expanded options is kept by the arena of their context.
+  static void operator delete(void* p);
+
+  /// Option "Class.Object.Name" of the object, made with the default value
+  /// of this option if not defined yet. Expanded options have no tag nor
+  /// help, they are owned by the context; deleting one removes it. Each
+  /// thread caches the result for the object until its class or name
+  /// changes, or an option is destroyed.
   CmdLineOption* Expand(TObject* obj);
   CmdLineOption* Expand(const TString& s1, const TString& s2);
 
+  /// Expands all templates for all objects at once. The names are built in
+  /// one buffer, the new options are placed in the arena together and
+  /// registered in one step. Their values are looked up at once and
+  /// converted by nthreads threads (all cores if 0). The options are
+  /// returned object by object, in the order of the templates; nullptr for
+  /// null objects.
+  static std::vector<CmdLineOption*>
+  Expand(const std::vector<TObject*>& objects,
+         const std::vector<CmdLineOption*>& templates, UInt_t nthreads = 0);
+  static std::vector<CmdLineOption*>
+  Expand(const TCollection* objects,
+         const std::vector<CmdLineOption*>& templates, UInt_t nthreads = 0);
+  template <typename Iterator>
+  static std::vector<CmdLineOption*>
+  Expand(Iterator first, Iterator last,
+         const std::vector<CmdLineOption*>& templates, UInt_t nthreads = 0) {
+    return Expand(std::vector<TObject*>(first, last), templates, nthreads);
+  }
+
   const char* GetHelp() const;
 
+  /// Writes the value into the variable whenever it is set or changes in
+  /// the active context: the command line, rc files, overrides, stored
+  /// states and restored defaults. The variable may be a number, TString or
+  /// std::string, plain or std::atomic. The binding ends with the returned
+  /// handle, the option or the context.
+  template <typename T> CmdLineBinding Bind(T& target) {
+    return AddBinding(CmdLineBinding::MakeWriter(target, this));
+  }
+
   const Bool_t GetFlagValue() const;
   const Bool_t GetBoolValue() const;
   const Int_t GetIntValue() const;
@@ -77,6 +140,10 @@ public:
   const Double_t GetDoubleArrayValue(const Int_t index);
   const Int_t GetArraySize();
   const char* GetStringValue(Bool_t arrayParsing = kFALSE);
+  /// All elements of an int or double option without copying them; valid
+  /// until the configuration changes.
+  CmdLineSpan<Int_t> GetIntArray() const;
+  CmdLineSpan<Double_t> GetDoubleArray() const;
 
   const Bool_t GetDefaultBoolValue() const;
   const Int_t GetDefaultIntValue() const;
@@ -96,6 +163,8 @@ public:
                                             const Int_t index);
   static const Int_t GetArraySize(const char* name);
   static const char* GetStringValue(const char* name);
+  static CmdLineSpan<Int_t> GetIntArray(const char* name);
+  static CmdLineSpan<Double_t> GetDoubleArray(const char* name);
 
   static const Bool_t GetDefaultBoolValue(const char* name);
   static const Int_t GetDefaultIntValue(const char* name);
@@ -110,6 +179,12 @@ public:
   void PrintHelp();
   void Print();
 
+  /// Converts all elements of the value to numbers of the given type, returns
+  /// kFALSE (and empty arrays) if any of them is malformed.
+  static Bool_t ParseValue(const char* value, OptionType type,
+                           std::vector<Int_t>& ints,
+                           std::vector<Double_t>& doubles);
+
   static Bool_t AbortOnWarning;
 
 private:
@@ -118,33 +193,56 @@ private:
   CmdLineOption(const char* name, Int_t defval);
   CmdLineOption(const char* name, Double_t defval);
   CmdLineOption(const char* name, const char* defval);
+  /// Expanded option of the template, not registered yet.
+  CmdLineOption(const CmdLineOption* tmpl, const char* name);
   CmdLineOption(const CmdLineOption& ref); // LCOV_EXCL_LINE
 
   void Init(const char* name, const char* cmd, const char* help);
+  Bool_t Convert(const char* value, CmdLineValue& result) const;
   Int_t GetValue(const char* name, Int_t def) const;
   Double_t GetValue(const char* name, Double_t def) const;
   const char* GetValue(const char* name, const char* def) const;
   const char* Getvalue(const char* name) const;
+  TEnvRec* Findvalue(const char* name) const;
 
   static const Int_t GetIntArrayValueFromString(const TString arraystring,
                                                 const Int_t index);
   static const Double_t GetDoubleArrayValueFromString(const TString arraystring,
                                                       const Int_t index);
   static const Int_t GetArraySizeFromString(const TString arraystring);
-  TString fName;   // name used in .sorterrc
-  TString fCmdArg; // name for command line
-  TString fHelp;   // help text
+  Int_t GetDefInt() const;
+  Double_t GetDefDouble() const;
+  const char* GetDefString() const;
 
-  Int_t fDefInt; // default values;
-  Double_t fDefDouble;
-  TString fDefString;
+  enum {
+    kExpanded = BIT(14), // made by Expand(), placed in the arena
+    kBound = BIT(15)     // variables are bound to the option
+  };
+
+  CmdLineBinding AddBinding(const CmdLineBinding::Writer& writer);
+  Double_t GetBoundNumber();
+  const char* GetBoundText();
+
+  CmdLineName fName;   //! name used in .sorterrc
+  CmdLineName fCmdArg; //! name for command line
+  CmdLineName fHelp;   //! help text
+
+  union {
+    Int_t fInt;          // flag, bool and int options
+    Double_t fDouble;    // double options
+    const char* fString; // string options, nullptr if none
+  } fDef;                //! default value of the type of the option
   OptionType fType;
 
   void (*fFunction)(); // function to be called when changed
 
+  CmdLineConfig* fConfig; // context the object is registered in
+
   static const TString delim;
 
   friend class CmdLineConfig;
+  friend class CmdLineSweep;
+  friend class CmdLineBinding;
 
   ClassDef(CmdLineOption, 0); // LCOV_EXCL_LINE
 };
@@ -0,0 +1,183 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineRange.cc
+  \brief
+
+  <long description>
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <algorithm>
+#include <charconv>
+#include <climits>
+#include <cstring>
+
+#include "CmdLineRange.hh"
+
+CmdLineRange::Iterator::Iterator(const CmdLineRange* range, size_t interval)
+    : fRange(range), fInterval(interval), fValue(0) {
+  if (fInterval < fRange->fIntervals.size())
+    fValue = fRange->fIntervals[fInterval].fFirst;
+}
+
+CmdLineRange::Iterator& CmdLineRange::Iterator::operator++() {
+  const Interval& in = fRange->fIntervals[fInterval];
+  if (fValue + in.fStep <= in.fLast) {
+    fValue += in.fStep;
+    return *this;
+  }
+
+  ++fInterval;
+  fValue = 0;
+  if (fInterval < fRange->fIntervals.size())
+    fValue = fRange->fIntervals[fInterval].fFirst;
+  return *this;
+}
+
+CmdLineRange::CmdLineRange() : fIndexed(kFALSE) {}
+
+static Bool_t ParseNumber(const char*& cp, const char* end, Long64_t& value) {
+  if (cp != end && *cp == '+') ++cp;
+  std::from_chars_result res = std::from_chars(cp, end, value);
+  if (res.ec != std::errc()) return kFALSE;
+  cp = res.ptr;
+  return kTRUE;
+}
+
+Bool_t CmdLineRange::Parse(const char* value) {
+  // parsed into a copy, so that a malformed value does not leave a part
+  CmdLineRange parsed;
+  const char* cp = value ? value : "";
+  while (*cp) {
+    while (*cp && strchr(" ,\t", *cp))
+      cp++;
+    if (!*cp) break;
+    const char* end = cp;
+    while (*end && !strchr(" ,\t", *end))
+      end++;
+
+    Long64_t first, last, step = 1;
+    const char* p = cp;
+    if (!ParseNumber(p, end, first)) return kFALSE;
+    if (p != end && *p == '-') {
+      ++p;
+      if (!ParseNumber(p, end, last)) return kFALSE;
+      if (p != end && *p == ':') {
+        ++p;
+        if (!ParseNumber(p, end, step)) return kFALSE;
+      }
+      if (p != end || !parsed.Add(first, last, step)) return kFALSE;
+    } else {
+      // single numbers, ':' separates them as in other arrays
+      while (kTRUE) {
+        if (first < INT_MIN || first > INT_MAX) return kFALSE;
+        parsed.Add(first);
+        if (p == end) break;
+        if (*p++ != ':' || !ParseNumber(p, end, first)) return kFALSE;
+      }
+    }
+    cp = end;
+  }
+
+  for (size_t i = 0; i < parsed.fIntervals.size(); ++i) {
+    const Interval& in = parsed.fIntervals[i];
+    Add(in.fFirst, in.fLast, in.fStep);
+  }
+  return kTRUE;
+}
+
+Bool_t CmdLineRange::Add(Long64_t first, Long64_t last, Long64_t step) {
+  if (first > last || step <= 0 || first < INT_MIN || last > INT_MAX)
+    return kFALSE;
+  last -= (last - first) % step;
+
+  fIndexed = kFALSE;
+  if (fIntervals.size()) {
+    // continuation of the previous interval extends it
+    Interval& prev = fIntervals.back();
+    if (prev.fFirst == prev.fLast && first == last && first > prev.fFirst) {
+      prev.fStep = first - prev.fFirst;
+      prev.fLast = first;
+      fOffsets.back() += 1;
+      return kTRUE;
+    }
+    if (first == prev.fLast + prev.fStep &&
+        (first == last || step == prev.fStep)) {
+      fOffsets.back() += (last - first) / prev.fStep + 1;
+      prev.fLast = last;
+      return kTRUE;
+    }
+  }
+
+  Interval in = {first, last, step};
+  fIntervals.push_back(in);
+  fOffsets.push_back(size() + in.Size());
+  return kTRUE;
+}
+
+void CmdLineRange::Clear() {
+  fIntervals.clear();
+  fOffsets.clear();
+  fSorted.clear();
+  fMaxLast.clear();
+  fIndexed = kFALSE;
+}
+
+Int_t CmdLineRange::At(ULong64_t index) const {
+  size_t k = std::upper_bound(fOffsets.begin(), fOffsets.end(), index) -
+             fOffsets.begin();
+  if (k >= fIntervals.size()) return 0;
+  ULong64_t before = k ? fOffsets[k - 1] : 0;
+  return fIntervals[k].fFirst + (index - before) * fIntervals[k].fStep;
+}
+
+void CmdLineRange::BuildIndex() const {
+  if (fIndexed) return;
+
+  fSorted.resize(fIntervals.size());
+  for (size_t i = 0; i < fSorted.size(); ++i)
+    fSorted[i] = i;
+  std::sort(fSorted.begin(), fSorted.end(), [this](size_t a, size_t b) {
+    return fIntervals[a].fFirst < fIntervals[b].fFirst;
+  });
+
+  fMaxLast.resize(fSorted.size());
+  for (size_t i = 0; i < fSorted.size(); ++i) {
+    fMaxLast[i] = fIntervals[fSorted[i]].fLast;
+    if (i && fMaxLast[i - 1] > fMaxLast[i]) fMaxLast[i] = fMaxLast[i - 1];
+  }
+  fIndexed = kTRUE;
+}
+
+Bool_t CmdLineRange::Contains(Long64_t value) const {
+  BuildIndex();
+
+  // the last interval starting not after the value, then back as long as
+  // earlier ones may still reach it (only if the intervals overlap)
+  size_t pos = std::upper_bound(fSorted.begin(), fSorted.end(), value,
+                                [this](Long64_t v, size_t i) {
+                                  return v < fIntervals[i].fFirst;
+                                }) -
+               fSorted.begin();
+  while (pos > 0 && fMaxLast[pos - 1] >= value) {
+    const Interval& in = fIntervals[fSorted[--pos]];
+    if (value <= in.fLast && (value - in.fFirst) % in.fStep == 0) return kTRUE;
+  }
+  return kFALSE;
+}
@@ -0,0 +1,114 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineRange.hh
+  \brief  Compact list of integers given as ranges
+
+  Values like "10000-19999 20500 21000-21999:10" are stored as intervals
+  with a stride. The elements are produced by an iterator and never stored
+  one by one.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINERANGE_HH
+#define _CMDLINERANGE_HH
+
+#include <iterator>
+#include <vector>
+
+#include <Rtypes.h>
+
+class CmdLineRange {
+public:
+  /// Elements first, first+step, ... up to last (inclusive).
+  struct Interval {
+    Long64_t fFirst;
+    Long64_t fLast;
+    Long64_t fStep;
+
+    ULong64_t Size() const { return (fLast - fFirst) / fStep + 1; }
+  };
+
+  class Iterator {
+  public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Int_t value_type;
+    typedef Long64_t difference_type;
+    typedef const Int_t* pointer;
+    typedef Int_t reference;
+
+    Iterator(const CmdLineRange* range, size_t interval);
+
+    Int_t operator*() const { return fValue; }
+    Iterator& operator++();
+    Iterator operator++(int) {
+      Iterator it = *this;
+      ++(*this);
+      return it;
+    }
+    bool operator==(const Iterator& it) const {
+      return fInterval == it.fInterval && fValue == it.fValue;
+    }
+    bool operator!=(const Iterator& it) const { return !(*this == it); }
+
+  private:
+    const CmdLineRange* fRange;
+    size_t fInterval; // current interval, number of intervals at the end
+    Long64_t fValue;
+  };
+
+  CmdLineRange();
+
+  /// Appends the elements of a value like "1-10:2,15 20:21". A range is
+  /// "first-last" with an optional ":step", other elements are single
+  /// numbers. Nothing is appended if the value is malformed.
+  Bool_t Parse(const char* value);
+  Bool_t Add(Long64_t first, Long64_t last, Long64_t step = 1);
+  void Add(Long64_t value) { Add(value, value); }
+  void Clear();
+
+  /// Number of elements.
+  ULong64_t size() const { return fOffsets.size() ? fOffsets.back() : 0; }
+  Bool_t empty() const { return fIntervals.empty(); }
+  /// Element at the position, found by bisection of the intervals.
+  Int_t At(ULong64_t index) const;
+  /// Tells whether the value is an element, by bisection of the intervals.
+  Bool_t Contains(Long64_t value) const;
+
+  Iterator begin() const { return Iterator(this, 0); }
+  Iterator end() const { return Iterator(this, fIntervals.size()); }
+
+  const std::vector<Interval>& GetIntervals() const { return fIntervals; }
+  /// Builds the lookup index, done by Contains() if needed. Call it before
+  /// the range is read from many threads.
+  void BuildIndex() const;
+
+private:
+  std::vector<Interval> fIntervals; // in order of appearance
+  std::vector<ULong64_t> fOffsets;  // elements up to and including interval
+
+  // intervals sorted by the first element, with the largest last element
+  // of all intervals up to that position
+  mutable std::vector<size_t> fSorted;
+  mutable std::vector<Long64_t> fMaxLast;
+  mutable Bool_t fIndexed;
+
+  friend class Iterator;
+};
+
+#endif
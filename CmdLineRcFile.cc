@@ -0,0 +1,174 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineRcFile.cc
+  \brief
+
+  Lines are split as by TEnvParser: the first character after the leading
+  blanks always belongs to the name, which ends at a blank, ':' or '('. A
+  type in parentheses may follow. The value starts after the blanks behind
+  the name, or after ':' behind the type, and runs to the end of the line.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CmdLineRcFile.hh"
+
+static Bool_t IsBlank(char c) { return c == ' ' || c == '\t'; }
+
+static const char* Copy(char*& out, const char* begin, const char* end) {
+  char* s = out;
+  memcpy(out, begin, end - begin);
+  out += end - begin;
+  *out++ = 0;
+  return s;
+}
+
+CmdLineRcFile::CmdLineRcFile() {}
+
+Int_t CmdLineRcFile::ReadFile(TEnv* env, const char* path, EEnvLevel level,
+                              const Lower& lower) {
+  CmdLineRcFile file;
+  if (!file.Read(path)) return -1;
+  file.Apply(env, level, lower);
+  return 0;
+}
+
+Bool_t CmdLineRcFile::Read(const char* path) {
+  // missing files are not reported, like by TEnv
+  int fd = open(path, O_RDONLY);
+  if (fd < 0) return kFALSE;
+
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return kFALSE;
+  }
+  size_t length = st.st_size;
+  if (length == 0) {
+    close(fd);
+    return kTRUE;
+  }
+
+  void* p = mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    std::cerr << "CmdLineRcFile: cannot map " << path << std::endl;
+    return kFALSE;
+  }
+  madvise(p, length, MADV_SEQUENTIAL);
+  Parse((const char*)p, length);
+  munmap(p, length);
+  return kTRUE;
+}
+
+void CmdLineRcFile::Parse(const char* text, size_t length) {
+  if (length == 0) return;
+
+  // a line takes at most its length and three terminators
+  const char* end = text + length;
+  size_t nlines = 1;
+  for (const char* p = text;
+       (p = (const char*)memchr(p, '\n', end - p)) != nullptr; ++p)
+    ++nlines;
+  char* out = (char*)fArena.Allocate(length + 3 * nlines, 1);
+
+  const char* line = text;
+  while (line < end) {
+    const char* eol = (const char*)memchr(line, '\n', end - line);
+    if (!eol) eol = end;
+    ParseLine(line, eol, out);
+    line = eol + 1;
+  }
+}
+
+void CmdLineRcFile::ParseLine(const char* begin, const char* end, char*& out) {
+  // carriage returns are ignored anywhere in the line
+  std::string stripped;
+  if (memchr(begin, '\r', end - begin)) {
+    stripped.assign(begin, end);
+    stripped.erase(std::remove(stripped.begin(), stripped.end(), '\r'),
+                   stripped.end());
+    begin = stripped.data();
+    end = begin + stripped.size();
+  }
+
+  const char* p = begin;
+  while (p < end && IsBlank(*p))
+    ++p;
+  if (p == end || *p == '#') return;
+
+  const char* name = p++;
+  while (p < end && !IsBlank(*p) && *p != ':' && *p != '(')
+    ++p;
+  const char* nameEnd = p;
+
+  const char* type = p;
+  const char* typeEnd = p;
+  if (p < end && *p == '(') {
+    type = ++p;
+    while (p < end && *p != ')')
+      ++p;
+    typeEnd = p;
+    if (p < end) ++p;
+    // only ':' behind the type is not part of the value
+    if (p < end && *p == ':') {
+      ++p;
+      while (p < end && IsBlank(*p))
+        ++p;
+    }
+  } else if (p < end) {
+    ++p;
+    while (p < end && IsBlank(*p))
+      ++p;
+  }
+
+  Record record;
+  record.fName = Copy(out, name, nameEnd);
+  record.fType = Copy(out, type, typeEnd);
+  record.fValue = Copy(out, p, end);
+  fRecords.push_back(record);
+}
+
+void CmdLineRcFile::Apply(TEnv* env, EEnvLevel level,
+                          const Lower& lower) const {
+  for (size_t i = 0; i < fRecords.size(); ++i) {
+    const Record& rec = fRecords[i];
+    // the environment holds one layer, appending continues the value of
+    // the key in the layers below
+    if (lower && rec.fName[0] == '+' && !env->Lookup(rec.fName + 1)) {
+      const char* value = lower(rec.fName + 1);
+      if (value) env->SetValue(rec.fName + 1, value, level, rec.fType);
+    }
+    env->SetValue(rec.fName, rec.fValue, level, rec.fType);
+  }
+}
+
+void CmdLineRcFile::Clear() {
+  fRecords.clear();
+  fArena.Clear();
+}
@@ -0,0 +1,81 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineRcFile.hh
+  \brief  Reader of rc files replacing TEnv::ReadFile()
+
+  The file is mapped and split into lines with memchr(), names, types and
+  values of all lines are copied into one block of memory. The syntax is
+  that of TEnv: '#' comments, "Name: value", "Name(type): value" and
+  "+Name: value" appending to the value. Records are set with
+  TEnv::SetValue(), which applies the levels and expands $(VAR), and
+  allocates a TEnvRec per key like TEnv::ReadFile(). A value
+  appended to a key of a lower layer starts with the value found there.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINERCFILE_HH
+#define _CMDLINERCFILE_HH
+
+#include <functional>
+#include <vector>
+
+#include <TEnv.h>
+
+#include "CmdLineArena.hh"
+
+class CmdLineRcFile {
+public:
+  struct Record {
+    const char* fName; // with '+' if appended
+    const char* fType; // "" if not given
+    const char* fValue;
+  };
+
+  /// Value of a key in the layers below the environment, nullptr if none.
+  typedef std::function<const char*(const char*)> Lower;
+
+  CmdLineRcFile();
+  virtual ~CmdLineRcFile() {}
+
+  /// Reads the file into the environment like TEnv::ReadFile(). Returns 0,
+  /// or -1 if the file cannot be read.
+  static Int_t ReadFile(TEnv* env, const char* path, EEnvLevel level,
+                        const Lower& lower = nullptr);
+
+  /// Parses the file, kFALSE if it cannot be read.
+  Bool_t Read(const char* path);
+  /// Parses the text, records of earlier calls are kept.
+  void Parse(const char* text, size_t length);
+  /// Sets the records in the environment, in the order of the file.
+  void Apply(TEnv* env, EEnvLevel level, const Lower& lower = nullptr) const;
+  void Clear();
+
+  const std::vector<Record>& GetRecords() const { return fRecords; }
+
+private:
+  CmdLineRcFile(const CmdLineRcFile&) = delete;
+  CmdLineRcFile& operator=(const CmdLineRcFile&) = delete;
+
+  void ParseLine(const char* begin, const char* end, char*& out);
+
+  CmdLineArena fArena;
+  std::vector<Record> fRecords;
+};
+
+#endif
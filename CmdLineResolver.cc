@@ -0,0 +1,179 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineResolver.cc
+  \brief
+
+  The search follows TUnixSystem::FindFile(): the file name is expanded,
+  absolute names are taken as they are, relative directories of the path
+  are relative to the working directory, which is thus part of the key.
+  Results depend on the directories containing the candidates, whose
+  entries are listed for the index and whose modification times tell that
+  entries were added, removed or renamed.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <cstring>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CmdLineResolver.hh"
+
+static Bool_t IsAccessible(const char* name, EAccessMode mode) {
+  struct stat st;
+  return access(name, mode) == 0 && stat(name, &st) == 0 &&
+         S_ISREG(st.st_mode);
+}
+
+static Bool_t GetMTime(const char* dir, Long64_t& mtime) {
+  struct stat st;
+  if (stat(dir, &st) != 0) return kFALSE;
+  mtime = st.st_mtim.tv_sec * 1000000000LL + st.st_mtim.tv_nsec;
+  return kTRUE;
+}
+
+CmdLineResolver::CmdLineResolver()
+    : fIndex(kFALSE), fValidation(0), fChecked(Clock::now()) {}
+
+CmdLineResolver* CmdLineResolver::instance() {
+  static CmdLineResolver resolver;
+  return &resolver;
+}
+
+TString CmdLineResolver::Resolve(const char* path, const char* file,
+                                 EAccessMode mode) {
+  if (!file || !*file) return "";
+
+  TString cwd = gSystem->WorkingDirectory();
+  std::string key = path ? path : ".";
+  key += '\0';
+  key += file;
+  key += '\0';
+  key += char('0' + mode);
+  key += cwd.Data();
+
+  std::lock_guard<std::mutex> lock(fMutex);
+  if (fValidation > 0 &&
+      Clock::now() - fChecked >= std::chrono::milliseconds(fValidation)) {
+    fChecked = Clock::now();
+    if (IsModified()) {
+      fEntries.clear();
+      fDirectories.clear();
+    }
+  }
+
+  std::unordered_map<std::string, TString>::const_iterator it =
+      fEntries.find(key);
+  if (it != fEntries.end()) return it->second;
+
+  TString result = Find(path, file, mode, cwd);
+  fEntries[key] = result;
+  return result;
+}
+
+TString CmdLineResolver::Find(const char* path, const char* file,
+                              EAccessMode mode, const TString& cwd) {
+  TString name = file;
+  gSystem->ExpandPathName(name);
+  if (name.BeginsWith("/")) {
+    if (fValidation > 0) Depend(name(0, name.Last('/') + 1));
+    return IsAccessible(name, mode) ? name : "";
+  }
+
+  for (const char* ptr = path ? path : "."; *ptr;) {
+    TString candidate;
+    if (*ptr != '/' && *ptr != '$' && *ptr != '~') candidate = cwd + "/";
+    const char* end = strchr(ptr, ':');
+    if (!end) end = ptr + strlen(ptr);
+    candidate.Append(ptr, end - ptr);
+    ptr = *end ? end + 1 : end;
+    if (!candidate.EndsWith("/")) candidate += "/";
+    candidate += name;
+    gSystem->ExpandPathName(candidate);
+
+    Ssiz_t slash = candidate.Last('/');
+    TString dir = candidate(0, slash + 1);
+    if (fValidation > 0) Depend(dir);
+    if (fIndex) {
+      Directory& directory = GetDirectory(dir);
+      if (!directory.fNames.count(candidate.Data() + slash + 1)) continue;
+    }
+    if (IsAccessible(candidate, mode)) return candidate;
+  }
+  return "";
+}
+
+CmdLineResolver::Directory& CmdLineResolver::GetDirectory(const TString& dir) {
+  Directory& directory = fDirectories[dir];
+  if (directory.fListed) return directory;
+
+  // listed once, until invalidated
+  directory.fListed = kTRUE;
+  void* dirp = gSystem->OpenDirectory(dir);
+  if (!dirp) return directory;
+  const char* entry;
+  while ((entry = gSystem->GetDirEntry(dirp)))
+    directory.fNames.insert(entry);
+  gSystem->FreeDirectory(dirp);
+  return directory;
+}
+
+void CmdLineResolver::Depend(const TString& dir) {
+  std::map<TString, Directory>::iterator it = fDirectories.find(dir);
+  if (it != fDirectories.end() && it->second.fMTime >= 0) return;
+
+  Directory& directory = fDirectories[dir];
+  if (!GetMTime(dir, directory.fMTime)) directory.fMTime = 0;
+}
+
+Bool_t CmdLineResolver::IsModified() {
+  std::map<TString, Directory>::const_iterator it;
+  for (it = fDirectories.begin(); it != fDirectories.end(); ++it) {
+    if (it->second.fMTime < 0) continue;
+    Long64_t mtime = 0;
+    GetMTime(it->first, mtime);
+    if (mtime != it->second.fMTime) return kTRUE;
+  }
+  return kFALSE;
+}
+
+void CmdLineResolver::SetIndex(Bool_t index) {
+  std::lock_guard<std::mutex> lock(fMutex);
+  fIndex = index;
+}
+
+void CmdLineResolver::SetValidation(Int_t interval_ms) {
+  // the directories of earlier results are not known
+  std::lock_guard<std::mutex> lock(fMutex);
+  fValidation = interval_ms;
+  fChecked = Clock::now();
+  fEntries.clear();
+  fDirectories.clear();
+}
+
+void CmdLineResolver::Invalidate() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  fEntries.clear();
+  fDirectories.clear();
+}
+
+size_t CmdLineResolver::GetNEntries() {
+  std::lock_guard<std::mutex> lock(fMutex);
+  return fEntries.size();
+}
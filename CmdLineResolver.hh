@@ -0,0 +1,95 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineResolver.hh
+  \brief  Cached lookup of files in search paths
+
+  Resolves files like gSystem->Which() and remembers the results, files not
+  found included, by search path, file name and access mode. Optionally the
+  directories of the search paths are listed once and names are looked up
+  in the listings. Results are kept until Invalidate() is called, or until a
+  directory they depend on is modified, if SetValidation() is given an
+  interval to compare the modification times in.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINERESOLVER_HH
+#define _CMDLINERESOLVER_HH
+
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <unordered_map>
+
+#include <TString.h>
+#include <TSystem.h>
+
+class CmdLineResolver {
+public:
+  CmdLineResolver();
+  virtual ~CmdLineResolver() {}
+
+  static CmdLineResolver* instance();
+
+  /// Path of the first regular file accessible in the mode in the ':'
+  /// separated search path, "" if there is none.
+  TString Resolve(const char* path, const char* file,
+                  EAccessMode mode = kFileExists);
+
+  /// Looks plain file names up in listings of the directories, made once.
+  void SetIndex(Bool_t index);
+  /// Compares the modification times of the directories the results depend
+  /// on at most once per interval and forgets all results if one changed.
+  /// With 0, the default, results are kept until Invalidate().
+  void SetValidation(Int_t interval_ms);
+  /// Forgets all results and listings.
+  void Invalidate();
+
+  size_t GetNEntries();
+
+private:
+  CmdLineResolver(const CmdLineResolver&) = delete;
+  CmdLineResolver& operator=(const CmdLineResolver&) = delete;
+
+  struct Directory {
+    Long64_t fMTime;              // in ns, 0 if missing, -1 if not compared
+    Bool_t fListed;
+    std::set<std::string> fNames; // listing, if fListed
+
+    Directory() : fMTime(-1), fListed(kFALSE) {}
+  };
+
+  typedef std::chrono::steady_clock Clock;
+
+  Directory& GetDirectory(const TString& dir);
+  void Depend(const TString& dir);
+  Bool_t IsModified();
+  TString Find(const char* path, const char* file, EAccessMode mode,
+               const TString& cwd);
+
+  std::unordered_map<std::string, TString> fEntries; // "" if not found
+  std::map<TString, Directory> fDirectories; // the results depend on
+  Bool_t fIndex;
+  Int_t fValidation;         // interval in ms, 0 if not validated
+  Clock::time_point fChecked; // last comparison of modification times
+  std::mutex fMutex;
+};
+
+#endif
@@ -0,0 +1,320 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineShm.cc
+  \brief
+
+  Layout of the segment: the header, an array of record offsets and the
+  records, each being the level, the lengths and the null terminated key
+  and value.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <TEnv.h>
+#include <THashList.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <new>
+#include <string>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "CmdLineShm.hh"
+
+static const char gMagic[8] = {'C', 'M', 'D', 'L', 'S', 'H', 'M', '1'};
+
+struct CmdLineShm::Header {
+  char fMagic[8];
+  std::atomic<ULong64_t> fVersion;
+  std::atomic<UInt_t> fStale; // set when a newer version is published
+  UInt_t fNRecords;
+  ULong64_t fSize;
+};
+
+struct CmdLineShm::Record {
+  Int_t fLevel;
+  UInt_t fKeyLength;
+  UInt_t fValueLength;
+  char fData[1]; // key and value, both null terminated
+};
+
+CmdLineShm::CmdLineShm(const char* name)
+    : fName(name), fHeader(nullptr), fSize(0), fListen(-1), fConnection(-1) {
+  if (!fName.BeginsWith("/")) fName.Prepend("/");
+}
+
+CmdLineShm::~CmdLineShm() {
+  Detach();
+  if (fConnection >= 0) close(fConnection);
+  for (size_t i = 0; i < fClients.size(); ++i)
+    close(fClients[i]);
+  if (fListen >= 0) close(fListen);
+}
+
+TString CmdLineShm::GetSocketPath() const {
+  const char* tmp = getenv("TMPDIR");
+  TString path = tmp && *tmp ? tmp : "/tmp";
+  TString name = fName;
+  name.ReplaceAll("/", "_");
+  return path + "/cmdline" + name + ".sock";
+}
+
+Bool_t CmdLineShm::Publish(TEnv* env) {
+  // records are serialized first, the segment is created with its final size
+  std::string data;
+  std::vector<UInt_t> offsets;
+  TIter it(env->GetTable());
+  TEnvRec* rec;
+  while ((rec = dynamic_cast<TEnvRec*>(it.Next()))) {
+    const char* key = rec->GetName();
+    const char* value = rec->GetValue() ? rec->GetValue() : "";
+    Record r;
+    r.fLevel = rec->GetLevel();
+    r.fKeyLength = strlen(key);
+    r.fValueLength = strlen(value);
+
+    while (data.size() % alignof(Record))
+      data.push_back(0);
+    offsets.push_back(data.size());
+    data.append((const char*)&r, offsetof(Record, fData));
+    data.append(key, r.fKeyLength + 1);
+    data.append(value, r.fValueLength + 1);
+  }
+
+  size_t head = sizeof(Header) + offsets.size() * sizeof(UInt_t);
+  head += (alignof(Record) - head % alignof(Record)) % alignof(Record);
+  size_t size = head + data.size();
+
+  // version continues the one of the previous segment, even if published by
+  // another server
+  ULong64_t version = 1;
+  Header* old = nullptr;
+  size_t oldsize = 0;
+  int fd = shm_open(fName, O_RDWR, 0);
+  if (fd >= 0) {
+    struct stat st;
+    if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(Header)) {
+      oldsize = st.st_size;
+      void* p = mmap(nullptr, oldsize, PROT_READ | PROT_WRITE, MAP_SHARED, fd,
+                     0);
+      if (p != MAP_FAILED) old = (Header*)p;
+    }
+    close(fd);
+    if (old && memcmp(old->fMagic, gMagic, sizeof(gMagic)) == 0)
+      version = old->fVersion.load() + 1;
+  }
+
+  shm_unlink(fName);
+  fd = shm_open(fName, O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0 || ftruncate(fd, size) != 0) {
+    std::cerr << "CmdLineShm: cannot create segment " << fName << std::endl;
+    if (fd >= 0) close(fd);
+    if (old) munmap(old, oldsize);
+    return kFALSE;
+  }
+  void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) {
+    if (old) munmap(old, oldsize);
+    return kFALSE;
+  }
+
+  Header* header = new (p) Header;
+  header->fStale.store(0);
+  header->fNRecords = offsets.size();
+  header->fSize = size;
+  UInt_t* table = (UInt_t*)(header + 1);
+  for (size_t i = 0; i < offsets.size(); ++i)
+    table[i] = head + offsets[i];
+  memcpy((char*)p + head, data.data(), data.size());
+  memcpy(header->fMagic, gMagic, sizeof(gMagic));
+  header->fVersion.store(version, std::memory_order_release);
+
+  if (old) {
+    old->fStale.store(1, std::memory_order_release);
+    munmap(old, oldsize);
+  }
+
+  Detach();
+  fHeader = header;
+  fSize = size;
+  return kTRUE;
+}
+
+Bool_t CmdLineShm::Listen() {
+  TString path = GetSocketPath();
+  sockaddr_un addr;
+  if ((size_t)path.Length() >= sizeof(addr.sun_path)) return kFALSE;
+
+  fListen = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fListen < 0) return kFALSE;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path.Data());
+  unlink(path.Data());
+  if (bind(fListen, (sockaddr*)&addr, sizeof(addr)) != 0 ||
+      listen(fListen, 64) != 0) {
+    std::cerr << "CmdLineShm: cannot listen on " << path << std::endl;
+    close(fListen);
+    fListen = -1;
+    return kFALSE;
+  }
+  fcntl(fListen, F_SETFL, O_NONBLOCK);
+  return kTRUE;
+}
+
+void CmdLineShm::Accept() {
+  if (fListen < 0) return;
+
+  int fd;
+  while ((fd = accept(fListen, nullptr, nullptr)) >= 0)
+    fClients.push_back(fd);
+}
+
+void CmdLineShm::Notify() {
+  if (fListen < 0) return;
+  Accept();
+
+  ULong64_t version = GetVersion();
+  for (size_t i = 0; i < fClients.size();) {
+    if (send(fClients[i], &version, sizeof(version), MSG_NOSIGNAL) ==
+        sizeof(version)) {
+      ++i;
+      continue;
+    }
+    // client is gone
+    close(fClients[i]);
+    fClients.erase(fClients.begin() + i);
+  }
+}
+
+void CmdLineShm::Unlink() {
+  shm_unlink(fName);
+  if (fListen >= 0) unlink(GetSocketPath());
+}
+
+Bool_t CmdLineShm::Attach() {
+  Detach();
+
+  int fd = shm_open(fName, O_RDONLY, 0);
+  if (fd < 0) return kFALSE;
+
+  struct stat st;
+  void* p = MAP_FAILED;
+  if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(Header))
+    p = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return kFALSE;
+
+  // the segment may still be filled by the server
+  Header* header = (Header*)p;
+  if (memcmp(header->fMagic, gMagic, sizeof(gMagic)) != 0 ||
+      header->fVersion.load(std::memory_order_acquire) == 0 ||
+      header->fSize > (ULong64_t)st.st_size) {
+    munmap(p, st.st_size);
+    return kFALSE;
+  }
+
+  fHeader = header;
+  fSize = st.st_size;
+  return kTRUE;
+}
+
+void CmdLineShm::Detach() {
+  if (fHeader) munmap(fHeader, fSize);
+  fHeader = nullptr;
+  fSize = 0;
+}
+
+Bool_t CmdLineShm::IsStale() const {
+  return fHeader && fHeader->fStale.load(std::memory_order_acquire);
+}
+
+Bool_t CmdLineShm::Connect() {
+  TString path = GetSocketPath();
+  sockaddr_un addr;
+  if ((size_t)path.Length() >= sizeof(addr.sun_path)) return kFALSE;
+
+  fConnection = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fConnection < 0) return kFALSE;
+
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strcpy(addr.sun_path, path.Data());
+  if (connect(fConnection, (sockaddr*)&addr, sizeof(addr)) != 0) {
+    close(fConnection);
+    fConnection = -1;
+    return kFALSE;
+  }
+  return kTRUE;
+}
+
+ULong64_t CmdLineShm::WaitUpdate(Int_t timeout_ms) {
+  if (fConnection < 0) return 0;
+
+  pollfd pfd = {fConnection, POLLIN, 0};
+  if (poll(&pfd, 1, timeout_ms) <= 0) return 0;
+
+  ULong64_t version = 0;
+  if (recv(fConnection, &version, sizeof(version), MSG_WAITALL) !=
+      sizeof(version))
+    return 0;
+  return version;
+}
+
+ULong64_t CmdLineShm::GetVersion() const {
+  return fHeader ? fHeader->fVersion.load(std::memory_order_acquire) : 0;
+}
+
+UInt_t CmdLineShm::GetNRecords() const {
+  return fHeader ? fHeader->fNRecords : 0;
+}
+
+const CmdLineShm::Record* CmdLineShm::GetRecord(UInt_t i) const {
+  const UInt_t* table = (const UInt_t*)(fHeader + 1);
+  return (const Record*)((const char*)fHeader + table[i]);
+}
+
+const char* CmdLineShm::GetKey(UInt_t i) const {
+  return GetRecord(i)->fData;
+}
+
+const char* CmdLineShm::GetValue(UInt_t i) const {
+  const Record* r = GetRecord(i);
+  return r->fData + r->fKeyLength + 1;
+}
+
+Int_t CmdLineShm::GetLevel(UInt_t i) const { return GetRecord(i)->fLevel; }
+
+Int_t CmdLineShm::Fill(TEnv* env) const {
+  UInt_t n = GetNRecords();
+  for (UInt_t i = 0; i < n; ++i)
+    env->SetValue(GetKey(i), GetValue(i), (EEnvLevel)GetLevel(i));
+  return n;
+}
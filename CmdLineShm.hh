@@ -0,0 +1,86 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineShm.hh
+  \brief  Configuration table shared by the processes of a node
+
+  The server (cmdlineshmd) reads the rc files once and publishes all records
+  in a POSIX shared memory segment. Every publication creates a new segment
+  with a higher version and marks the previous one stale; clients connected
+  to the Unix socket of the server receive the new version number.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINESHM_HH
+#define _CMDLINESHM_HH
+
+#include <vector>
+
+#include <TString.h>
+
+class TEnv;
+
+class CmdLineShm {
+public:
+  CmdLineShm(const char* name);
+  virtual ~CmdLineShm();
+
+  // server side
+  Bool_t Publish(TEnv* env);
+  Bool_t Listen();
+  void Accept();
+  void Notify();
+  void Unlink();
+  Int_t GetListenSocket() const { return fListen; }
+
+  // client side
+  Bool_t Attach();
+  void Detach();
+  Bool_t IsAttached() const { return fHeader != nullptr; }
+  /// Tells whether a newer version was published since attaching.
+  Bool_t IsStale() const;
+  Bool_t Connect();
+  /// Waits for a notification of the server, returns the new version or 0.
+  ULong64_t WaitUpdate(Int_t timeout_ms);
+
+  ULong64_t GetVersion() const;
+  UInt_t GetNRecords() const;
+  const char* GetKey(UInt_t i) const;
+  const char* GetValue(UInt_t i) const;
+  Int_t GetLevel(UInt_t i) const;
+  /// Copies all records into the environment, returns their number.
+  Int_t Fill(TEnv* env) const;
+
+  const TString& GetName() const { return fName; }
+  TString GetSocketPath() const;
+
+private:
+  struct Header;
+  struct Record;
+
+  const Record* GetRecord(UInt_t i) const;
+
+  TString fName;       // name of the segment, starts with '/'
+  Header* fHeader;     // mapped segment, nullptr if not attached
+  size_t fSize;        // size of the mapping
+  Int_t fListen;       // listening socket of the server
+  Int_t fConnection;   // socket of the client
+  std::vector<Int_t> fClients; // connected clients
+};
+
+#endif
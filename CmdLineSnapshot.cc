@@ -0,0 +1,72 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineSnapshot.cc
+  \brief
+
+  <long description>
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <cstring>
+#include <functional>
+#include <string_view>
+
+#include "CmdLineSnapshot.hh"
+
+size_t CmdLineSnapshot::GetNValues() const {
+  size_t n = 0;
+  for (Int_t t = 0; t < kNTables; ++t)
+    for (Int_t b = 0; b < kNBuckets; ++b)
+      if (fBuckets[t][b]) n += fBuckets[t][b]->size();
+  return n;
+}
+
+const char* CmdLineSnapshot::GetValue(Int_t table, const char* key) const {
+  const std::shared_ptr<const Bucket>& bucket = fBuckets[table][Index(key)];
+  if (!bucket) return nullptr;
+  Bucket::const_iterator it = bucket->find(key);
+  return it != bucket->end() ? it->second.Data() : nullptr;
+}
+
+size_t CmdLineSnapshot::Index(const char* key) {
+  return std::hash<std::string_view>()(std::string_view(key, strlen(key))) %
+         kNBuckets;
+}
+
+void CmdLineSnapshot::Set(Int_t table, const char* key, const char* value) {
+  std::shared_ptr<const Bucket>& bucket = fBuckets[table][Index(key)];
+  // buckets shared with snapshots are copied before the change
+  if (!bucket)
+    bucket = std::make_shared<Bucket>();
+  else if (bucket.use_count() > 1)
+    bucket = std::make_shared<Bucket>(*bucket);
+  (*const_cast<Bucket*>(bucket.get()))[key] = value;
+}
+
+void CmdLineSnapshot::Erase(Int_t table, const char* key) {
+  std::shared_ptr<const Bucket>& bucket = fBuckets[table][Index(key)];
+  if (!bucket || bucket->find(key) == bucket->end()) return;
+  if (bucket.use_count() > 1) bucket = std::make_shared<Bucket>(*bucket);
+  const_cast<Bucket*>(bucket.get())->erase(key);
+}
+
+void CmdLineSnapshot::Clear(Int_t table) {
+  for (Int_t b = 0; b < kNBuckets; ++b)
+    fBuckets[table][b].reset();
+}
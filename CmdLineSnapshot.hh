@@ -0,0 +1,59 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineSnapshot.hh
+  \brief  Values of the command line and runtime layers at some point
+
+  The values are spread over a fixed number of buckets held by shared
+  pointers. Copying a snapshot copies the pointers only; a bucket is copied
+  when it is modified while shared, so the context and its snapshots share
+  all unchanged buckets.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINESNAPSHOT_HH
+#define _CMDLINESNAPSHOT_HH
+
+#include <map>
+#include <memory>
+
+#include <TString.h>
+
+class CmdLineSnapshot {
+public:
+  /// Number of values, counts all buckets.
+  size_t GetNValues() const;
+  /// Value of the key in the command line (0) or runtime (1) table.
+  const char* GetValue(Int_t table, const char* key) const;
+
+private:
+  friend class CmdLineConfig;
+
+  enum { kNTables = 2, kNBuckets = 64 };
+  typedef std::map<TString, TString> Bucket;
+
+  static size_t Index(const char* key);
+
+  void Set(Int_t table, const char* key, const char* value);
+  void Erase(Int_t table, const char* key);
+  void Clear(Int_t table);
+
+  std::shared_ptr<const Bucket> fBuckets[kNTables][kNBuckets]; // null if empty
+};
+
+#endif
@@ -0,0 +1,73 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineState.cc
+  \brief
+
+  <long description>
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <iomanip>
+#include <iostream>
+
+#include "CmdLineState.hh"
+
+CmdLineState::CmdLineState(const char* name)
+    : TNamed(name, "resolved configuration"), fGreedyType(0) {}
+
+CmdLineState::~CmdLineState() {}
+
+void CmdLineState::Clear(Option_t*) {
+  fOptNames.clear();
+  fOptTypes.clear();
+  fOptValues.clear();
+  fArgNames.clear();
+  fArgTypes.clear();
+  fArgValues.clear();
+  fGreedyType = 0;
+  fGreedyValues.clear();
+  fEnvNames.clear();
+  fEnvValues.clear();
+  fEnvLevels.clear();
+}
+
+const char* CmdLineState::GetOptionValue(const char* name) const {
+  for (size_t i = 0; i < fOptNames.size(); ++i)
+    if (fOptNames[i] == name) return fOptValues[i].Data();
+
+  return nullptr;
+}
+
+void CmdLineState::Print(Option_t*) const {
+  std::cout << "Stored settings:" << std::endl;
+  for (size_t i = 0; i < fOptNames.size(); ++i)
+    std::cout << "  " << std::resetiosflags(std::ios::adjustfield)
+              << std::setiosflags(std::ios::left) << std::setw(20)
+              << fOptNames[i] << "'" << fOptValues[i] << "'" << std::endl;
+
+  for (size_t i = 0; i < fArgNames.size(); ++i)
+    std::cout << "   " << std::setw(19) << fArgNames[i] << "'" << fArgValues[i]
+              << "'" << std::endl;
+
+  for (size_t i = 0; i < fGreedyValues.size(); ++i)
+    std::cout << "   " << std::setw(19) << "[...]"
+              << "'" << fGreedyValues[i] << "'" << std::endl;
+
+  std::cout << std::resetiosflags(std::ios::adjustfield);
+}
@@ -0,0 +1,77 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineState.hh
+  \brief  Streamable record of the resolved configuration
+
+  Holds the resolved value and type of every registered option and argument,
+  together with the raw records of the rc table. The object can be written to
+  an output file and later loaded back with CmdLineConfig::LoadState(), which
+  skips rc parsing entirely.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINESTATE_HH
+#define _CMDLINESTATE_HH
+
+#include "TNamed.h"
+#include "TString.h"
+
+#include <vector>
+
+class CmdLineState : public TNamed {
+public:
+  CmdLineState(const char* name = "CmdLineState");
+  virtual ~CmdLineState();
+
+  void Clear(Option_t* option = "");
+
+  Int_t GetNOptions() const { return fOptNames.size(); }
+  const char* GetOptionName(Int_t i) const { return fOptNames[i].Data(); }
+  Int_t GetOptionType(Int_t i) const { return fOptTypes[i]; }
+  const char* GetOptionValue(Int_t i) const { return fOptValues[i].Data(); }
+  const char* GetOptionValue(const char* name) const;
+
+  Int_t GetNArguments() const { return fArgNames.size(); }
+  Int_t GetNGreedy() const { return fGreedyValues.size(); }
+  Int_t GetNRecords() const { return fEnvNames.size(); }
+
+  void Print(Option_t* option = "") const;
+
+private:
+  std::vector<TString> fOptNames;  // registered option names
+  std::vector<Int_t> fOptTypes;    // CmdLineOption::OptionType of each option
+  std::vector<TString> fOptValues; // resolved value of each option
+
+  std::vector<TString> fArgNames;  // positional argument names
+  std::vector<Int_t> fArgTypes;    // CmdLineArg::OptionType of each argument
+  std::vector<TString> fArgValues; // positional argument values
+
+  Int_t fGreedyType;                  // type of the greedy argument
+  std::vector<TString> fGreedyValues; // greedy argument values
+
+  std::vector<TString> fEnvNames;  // raw rc table keys
+  std::vector<TString> fEnvValues; // raw rc table values
+  std::vector<Int_t> fEnvLevels;   // EEnvLevel of each record
+
+  friend class CmdLineConfig;
+
+  ClassDef(CmdLineState, 1); // LCOV_EXCL_LINE
+};
+
+#endif
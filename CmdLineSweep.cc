@@ -0,0 +1,188 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineSweep.cc
+  \brief
+
+  <long description>
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <TObjArray.h>
+#include <TObjString.h>
+
+#include <cmath>
+#include <iostream>
+
+#include "CmdLineConfig.hh"
+#include "CmdLineSweep.hh"
+
+CmdLineSweep::CmdLineSweep(CmdLineConfig* parent)
+    : fParent(parent ? parent : CmdLineConfig::instance()), fCommon(nullptr) {}
+
+CmdLineSweep::~CmdLineSweep() { delete fCommon; }
+
+Bool_t CmdLineSweep::ParseAxis(CmdLineOption* opt, const char* value,
+                               Axis& axis) const {
+  TString str = value;
+  axis.fOption = opt;
+  axis.fList.clear();
+  axis.fFirst = axis.fStep = 0.;
+  axis.fSize = 0;
+
+  std::vector<Int_t> ints;
+  std::vector<Double_t> doubles;
+
+  // only values in braces are swept, others are ordinary values or arrays
+  if (!str.BeginsWith("{") || !str.EndsWith("}")) return kFALSE;
+  TString list = str(1, str.Length() - 2);
+
+  if (list.CountChar(':') != 2 || list.Contains(",")) {
+    TObjArray* items = list.Tokenize(",");
+    for (Int_t i = 0; i < items->GetEntries(); ++i) {
+      TString item = dynamic_cast<TObjString*>(items->At(i))->GetString();
+      item = item.Strip(TString::kBoth);
+      if (opt->fType != CmdLineOption::kString &&
+          opt->fType != CmdLineOption::kStringNotChecked &&
+          (!CmdLineOption::ParseValue(item, opt->fType, ints, doubles) ||
+           ints.size() + doubles.size() != 1)) {
+        std::cerr << "CmdLineSweep: invalid value '" << item << "' of "
+                  << opt->fName << " in " << value << std::endl;
+        delete items;
+        return kFALSE;
+      }
+      axis.fList.push_back(item);
+    }
+    delete items;
+    axis.fSize = axis.fList.size();
+    return axis.fSize > 0;
+  }
+
+  // {first:last:step}
+  if (opt->fType != CmdLineOption::kInt &&
+      opt->fType != CmdLineOption::kDouble)
+    return kFALSE;
+  if (!CmdLineOption::ParseValue(list, opt->fType, ints, doubles) ||
+      ints.size() + doubles.size() != 3) {
+    std::cerr << "CmdLineSweep: invalid range " << value << " of "
+              << opt->fName << std::endl;
+    return kFALSE;
+  }
+
+  Double_t first, last;
+  if (opt->fType == CmdLineOption::kInt) {
+    first = ints[0];
+    last = ints[1];
+    axis.fStep = ints[2];
+  } else {
+    first = doubles[0];
+    last = doubles[1];
+    axis.fStep = doubles[2];
+  }
+  if (axis.fStep == 0. || (last - first) / axis.fStep < 0.) {
+    std::cerr << "CmdLineSweep: empty range " << value << " of "
+              << opt->fName << std::endl;
+    return kFALSE;
+  }
+
+  axis.fFirst = first;
+  // tolerance for the rounding of decimal steps
+  axis.fSize = (size_t)std::floor((last - first) / axis.fStep + 1e-9) + 1;
+  return kTRUE;
+}
+
+TString CmdLineSweep::GetAxisValue(const Axis& axis, size_t index) const {
+  if (axis.fList.size()) return axis.fList[index];
+
+  Double_t value = axis.fFirst + index * axis.fStep;
+  if (axis.fOption->fType == CmdLineOption::kInt)
+    return TString::Format("%lld", (Long64_t)std::llround(value));
+  // 15 digits hide the rounding errors of the sum
+  return TString::Format("%.15g", value);
+}
+
+void CmdLineSweep::ReadCmdLine(int argc, char** argv) {
+  fAxes.clear();
+  delete fCommon;
+  fCommon = nullptr;
+
+  std::vector<char*> rest;
+  rest.push_back(argv[0]);
+
+  for (Int_t i = 1; i < argc; ++i) {
+    CmdLineOption* opt = nullptr;
+    for (CmdLineConfig* cfg = fParent; cfg && !opt; cfg = cfg->fParent) {
+      CmdLineConfig::Options::const_iterator it = cfg->fOpts.begin();
+      while (it != cfg->fOpts.end() && !opt) {
+        CmdLineOption* entry = (it++)->second;
+        if (entry->fCmdArg != "" && entry->fCmdArg == argv[i]) opt = entry;
+      }
+    }
+
+    rest.push_back(argv[i]);
+    if (!opt || opt->fType == CmdLineOption::kFlag || i + 1 >= argc) continue;
+
+    Axis axis;
+    if (ParseAxis(opt, argv[i + 1], axis)) {
+      // swept options are set in the contexts of the points only
+      rest.pop_back();
+      // the last value wins, as on an ordinary command line
+      for (size_t a = 0; a < fAxes.size(); ++a)
+        if (fAxes[a].fOption == opt) {
+          fAxes.erase(fAxes.begin() + a);
+          break;
+        }
+      fAxes.push_back(axis);
+    } else {
+      rest.push_back(argv[i + 1]);
+    }
+    ++i;
+  }
+
+  fCommon = new CmdLineConfig(fParent);
+  fCommon->ReadCmdLine(rest.size(), rest.data());
+}
+
+size_t CmdLineSweep::GetNPoints() const {
+  size_t n = 1;
+  for (size_t a = 0; a < fAxes.size(); ++a)
+    n *= fAxes[a].fSize;
+  return n;
+}
+
+TString CmdLineSweep::GetValue(size_t point, size_t axis) const {
+  for (size_t a = fAxes.size(); a-- > axis + 1;)
+    point /= fAxes[a].fSize;
+  return GetAxisValue(fAxes[axis], point % fAxes[axis].fSize);
+}
+
+void CmdLineSweep::Run(const BatchCallback& callback, UInt_t nthreads) {
+  if (!fCommon) return;
+
+  // rc files are read once, all points share them
+  fCommon->GetEnv();
+
+  CmdLineBatch::ParallelFor(GetNPoints(), nthreads, [&](size_t point) {
+    CmdLineConfig view(fCommon);
+    for (size_t a = 0; a < fAxes.size(); ++a)
+      view.SetValue("CmdLine." + fAxes[a].fOption->fName, GetValue(point, a));
+
+    CmdLineConfig::Scope scope(&view);
+    callback(view, point);
+  });
+}
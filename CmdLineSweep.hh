@@ -0,0 +1,78 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineSweep.hh
+  \brief  Runs a command line for every point of a parameter grid
+
+  Values of int and double options given as a range "{first:last:step}" or
+  of any option given as a list "{a,b,c}" are swept. The rest of the command line is parsed once into a
+  common context, every point of the Cartesian product gets a child context
+  holding only the swept values.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINESWEEP_HH
+#define _CMDLINESWEEP_HH
+
+#include <vector>
+
+#include <TString.h>
+
+#include "CmdLineBatch.hh"
+
+class CmdLineConfig;
+class CmdLineOption;
+
+class CmdLineSweep {
+public:
+  CmdLineSweep(CmdLineConfig* parent = nullptr);
+  virtual ~CmdLineSweep();
+
+  /// Takes the swept options out of the command line, the rest is read into
+  /// the common context.
+  void ReadCmdLine(int argc, char** argv);
+
+  size_t GetNAxes() const { return fAxes.size(); }
+  CmdLineOption* GetOption(size_t axis) const { return fAxes[axis].fOption; }
+  size_t GetNValues(size_t axis) const { return fAxes[axis].fSize; }
+  /// Number of points, product of the numbers of values of all axes.
+  size_t GetNPoints() const;
+  /// Value of the axis at the point, the last axis changes fastest.
+  TString GetValue(size_t point, size_t axis) const;
+  CmdLineConfig* GetCommon() const { return fCommon; }
+
+  void Run(const BatchCallback& callback, UInt_t nthreads = 0);
+
+private:
+  struct Axis {
+    CmdLineOption* fOption;
+    std::vector<TString> fList; // values of a list
+    Double_t fFirst;            // first value and step of a range
+    Double_t fStep;
+    size_t fSize;
+  };
+
+  Bool_t ParseAxis(CmdLineOption* opt, const char* value, Axis& axis) const;
+  TString GetAxisValue(const Axis& axis, size_t index) const;
+
+  CmdLineConfig* fParent;
+  CmdLineConfig* fCommon; // context of the not swept part
+  std::vector<Axis> fAxes;
+};
+
+#endif
@@ -0,0 +1,149 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineTree.cc
+  \brief
+
+  <long description>
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <algorithm>
+
+#include "CmdLineTree.hh"
+
+CmdLineTree::CmdLineTree() {}
+
+void CmdLineTree::Clear() {
+  fEntries.clear();
+  fNodes.clear();
+  fArena.Clear();
+}
+
+void CmdLineTree::Add(const char* name, const char* value,
+                      CmdLineOption* opt) {
+  Entry entry;
+  entry.fName = std::string_view(fArena.Copy(name), strlen(name));
+  entry.fValue = value && *value ? fArena.Copy(value) : "";
+  entry.fOption = opt;
+  fEntries.push_back(entry);
+}
+
+bool CmdLineTree::Less(const Entry& a, const Entry& b) {
+  size_t n = std::min(a.fName.size(), b.fName.size());
+  for (size_t i = 0; i < n; ++i) {
+    unsigned char ca = a.fName[i];
+    unsigned char cb = b.fName[i];
+    if (ca == cb) continue;
+    // separators first, so that the names below a prefix are adjacent
+    if (ca == '.') return true;
+    if (cb == '.') return false;
+    return ca < cb;
+  }
+  return a.fName.size() < b.fName.size();
+}
+
+void CmdLineTree::Build() {
+  std::sort(fEntries.begin(), fEntries.end(), Less);
+
+  fNodes.clear();
+  Node root = {std::string_view(), std::string_view(), 0,
+               (UInt_t)fEntries.size(), 0, 0};
+  fNodes.push_back(root);
+  BuildChildren(0);
+}
+
+void CmdLineTree::BuildChildren(UInt_t node) {
+  std::string_view path = fNodes[node].fPath;
+  size_t skip = path.empty() ? 0 : path.size() + 1;
+  UInt_t i = fNodes[node].fBegin;
+  UInt_t end = fNodes[node].fEnd;
+  // the name equal to the path sorts first, it is not a child
+  if (i < end && fEntries[i].fName.size() <= path.size()) ++i;
+
+  std::vector<Node> children;
+  while (i < end) {
+    std::string_view rest = fEntries[i].fName.substr(skip);
+    Node child;
+    child.fName = rest.substr(0, rest.find('.'));
+    child.fPath = fEntries[i].fName.substr(0, skip + child.fName.size());
+    child.fBegin = i;
+    child.fFirstChild = 0;
+    child.fNChildren = 0;
+    while (i < end) {
+      std::string_view name = fEntries[i].fName;
+      if (name.compare(0, child.fPath.size(), child.fPath)) break;
+      if (name.size() > child.fPath.size() && name[child.fPath.size()] != '.')
+        break;
+      ++i;
+    }
+    child.fEnd = i;
+    children.push_back(child);
+  }
+
+  UInt_t first = fNodes.size();
+  fNodes[node].fFirstChild = first;
+  fNodes[node].fNChildren = children.size();
+  fNodes.insert(fNodes.end(), children.begin(), children.end());
+  for (UInt_t c = 0; c < children.size(); ++c)
+    BuildChildren(first + c);
+}
+
+static bool NodeLess(const CmdLineTree::Node& node, std::string_view name) {
+  return node.fName < name;
+}
+
+const CmdLineTree::Node* CmdLineTree::FindNode(std::string_view prefix) const {
+  if (fNodes.empty()) return nullptr;
+
+  const Node* node = &fNodes[0];
+  while (!prefix.empty()) {
+    std::string_view name = prefix.substr(0, prefix.find('.'));
+    prefix.remove_prefix(std::min(name.size() + 1, prefix.size()));
+
+    const Node* first = fNodes.data() + node->fFirstChild;
+    const Node* last = first + node->fNChildren;
+    const Node* it = std::lower_bound(first, last, name, NodeLess);
+    if (it == last || it->fName != name) return nullptr;
+    node = it;
+  }
+  return node;
+}
+
+CmdLineSpan<CmdLineTree::Entry>
+CmdLineTree::GetEntries(const Node& node) const {
+  return CmdLineSpan<Entry>(fEntries.data() + node.fBegin,
+                            node.fEnd - node.fBegin);
+}
+
+CmdLineSpan<CmdLineTree::Node>
+CmdLineTree::GetChildren(const Node& node) const {
+  return CmdLineSpan<Node>(fNodes.data() + node.fFirstChild, node.fNChildren);
+}
+
+CmdLineSpan<CmdLineTree::Entry>
+CmdLineTree::Find(std::string_view prefix) const {
+  const Node* node = FindNode(prefix);
+  return node ? GetEntries(*node) : CmdLineSpan<Entry>();
+}
+
+CmdLineSpan<CmdLineTree::Node>
+CmdLineTree::GetChildren(std::string_view prefix) const {
+  const Node* node = FindNode(prefix);
+  return node ? GetChildren(*node) : CmdLineSpan<Node>();
+}
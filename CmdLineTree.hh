@@ -0,0 +1,90 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineTree.hh
+  \brief  Index of dot-separated names by their components
+
+  Names like "Detector.Layer3.Gain" are sorted so that all names under a
+  prefix are adjacent, and a tree of their components points to the ranges.
+  Names under a prefix, their number and their children are found without
+  scanning all names.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINETREE_HH
+#define _CMDLINETREE_HH
+
+#include <string_view>
+#include <vector>
+
+#include "CmdLineArena.hh"
+#include "CmdLineMap.hh"
+
+class CmdLineOption;
+
+class CmdLineTree {
+public:
+  struct Entry {
+    std::string_view fName; // full name
+    const char* fValue;     // value in effect, "" if none
+    CmdLineOption* fOption; // nullptr for keys of the rc files
+  };
+
+  struct Node {
+    std::string_view fName; // last component
+    std::string_view fPath; // components up to this one
+    UInt_t fBegin;          // entries of the subtree
+    UInt_t fEnd;
+    UInt_t fFirstChild; // children are adjacent, sorted by name
+    UInt_t fNChildren;
+  };
+
+  CmdLineTree();
+  virtual ~CmdLineTree() {}
+
+  void Clear();
+  /// Adds a name, the name and value are copied. Build() must be called
+  /// after all names are added.
+  void Add(const char* name, const char* value, CmdLineOption* opt = nullptr);
+  void Build();
+
+  /// Entries equal to the prefix or below it, sorted by components. An empty
+  /// prefix gives all entries.
+  CmdLineSpan<Entry> Find(std::string_view prefix) const;
+  size_t Count(std::string_view prefix) const { return Find(prefix).size(); }
+  /// Components below the prefix.
+  CmdLineSpan<Node> GetChildren(std::string_view prefix) const;
+  /// Node of the prefix, nullptr if no name is below it.
+  const Node* FindNode(std::string_view prefix) const;
+  CmdLineSpan<Entry> GetEntries(const Node& node) const;
+  CmdLineSpan<Node> GetChildren(const Node& node) const;
+  size_t GetNEntries() const { return fEntries.size(); }
+
+private:
+  CmdLineTree(const CmdLineTree&) = delete;
+  CmdLineTree& operator=(const CmdLineTree&) = delete;
+
+  static bool Less(const Entry& a, const Entry& b);
+  void BuildChildren(UInt_t node);
+
+  CmdLineArena fArena; // names and values
+  std::vector<Entry> fEntries;
+  std::vector<Node> fNodes; // the root first
+};
+
+#endif
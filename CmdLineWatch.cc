@@ -0,0 +1,198 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineWatch.cc
+  \brief
+
+  Directories are watched rather than the files, editors replace a file by
+  renaming a new one over it. Besides the files read, new rc files in the
+  directories count as changes, e.g. in the DefaultPath directory.
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "CmdLineWatch.hh"
+
+static const uint32_t gWatchMask = IN_CLOSE_WRITE | IN_MOVED_TO |
+                                   IN_MOVED_FROM | IN_CREATE | IN_DELETE;
+
+CmdLineWatch::CmdLineWatch(CmdLineConfig* config)
+    : fConfig(config ? config : CmdLineConfig::instance()), fInotify(-1),
+      fFifo(-1), fFifoWriter(-1), fLatency(50) {}
+
+CmdLineWatch::~CmdLineWatch() {
+  if (fInotify >= 0) close(fInotify);
+  if (fFifo >= 0) close(fFifo);
+  if (fFifoWriter >= 0) close(fFifoWriter);
+  if (!fFifoPath.IsNull()) unlink(fFifoPath);
+}
+
+Bool_t CmdLineWatch::Start() {
+  if (fInotify >= 0) return kTRUE;
+
+  fConfig->GetEnv();
+  fInotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+  if (fInotify < 0) {
+    std::cerr << "CmdLineWatch: cannot watch files, " << strerror(errno)
+              << std::endl;
+    return kFALSE;
+  }
+  Watch();
+  return kTRUE;
+}
+
+void CmdLineWatch::Watch() {
+  // the files read may change with the values of Include and DefaultPath
+  std::map<TString, std::set<TString>> dirs;
+  const std::vector<TString>& files = fConfig->GetRcFiles();
+  for (size_t i = 0; i < files.size(); ++i) {
+    Ssiz_t slash = files[i].Last('/');
+    TString dir = slash < 0 ? TString(".") : files[i](0, slash + 1);
+    dirs[dir].insert(files[i](slash + 1, files[i].Length()));
+  }
+
+  std::map<Int_t, std::set<TString>> watches;
+  std::map<TString, std::set<TString>>::const_iterator it;
+  for (it = dirs.begin(); it != dirs.end(); ++it) {
+    Int_t wd = inotify_add_watch(fInotify, it->first, gWatchMask);
+    if (wd < 0) continue;
+    watches[wd].insert(it->second.begin(), it->second.end());
+  }
+
+  std::map<Int_t, std::set<TString>>::const_iterator old;
+  for (old = fWatches.begin(); old != fWatches.end(); ++old)
+    if (!watches.count(old->first)) inotify_rm_watch(fInotify, old->first);
+  fWatches.swap(watches);
+}
+
+Bool_t CmdLineWatch::OpenFifo(const char* path) {
+  struct stat st;
+  if (stat(path, &st) != 0) {
+    if (mkfifo(path, 0600) != 0) {
+      std::cerr << "CmdLineWatch: cannot create " << path << ", "
+                << strerror(errno) << std::endl;
+      return kFALSE;
+    }
+    fFifoPath = path;
+  } else if (!S_ISFIFO(st.st_mode)) {
+    std::cerr << "CmdLineWatch: " << path << " is not a FIFO" << std::endl;
+    return kFALSE;
+  }
+
+  fFifo = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+  if (fFifo < 0) {
+    std::cerr << "CmdLineWatch: cannot open " << path << ", "
+              << strerror(errno) << std::endl;
+    return kFALSE;
+  }
+  // without a writer the pipe would be at its end after every client
+  fFifoWriter = open(path, O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+  return kTRUE;
+}
+
+Int_t CmdLineWatch::Poll(Int_t timeout_ms) {
+  if (!Wait(timeout_ms)) return 0;
+
+  Bool_t files = kFALSE;
+  KeyValues values;
+  Collect(files, values);
+  // a change comes in several events, e.g. an editor saving a file; a
+  // steady stream of them is cut after a few rounds
+  for (Int_t i = 0; i < 10 && fLatency > 0 && Wait(fLatency); ++i)
+    Collect(files, values);
+  if (!files && values.empty()) return 0;
+
+  Int_t changed = fConfig->Update(values, files);
+  if (files) Watch();
+  return changed;
+}
+
+Bool_t CmdLineWatch::Wait(Int_t timeout_ms) {
+  pollfd fds[2];
+  nfds_t n = 0;
+  if (fInotify >= 0) fds[n++] = {fInotify, POLLIN, 0};
+  if (fFifo >= 0) fds[n++] = {fFifo, POLLIN, 0};
+  if (n == 0) return kFALSE;
+
+  Int_t ready;
+  do {
+    ready = poll(fds, n, timeout_ms);
+  } while (ready < 0 && errno == EINTR);
+  return ready > 0;
+}
+
+void CmdLineWatch::Collect(Bool_t& files, KeyValues& values) {
+  char buf[4096] __attribute__((aligned(__alignof__(inotify_event))));
+  ssize_t len;
+  while (fInotify >= 0 && (len = read(fInotify, buf, sizeof(buf))) > 0) {
+    for (char* p = buf; p < buf + len;) {
+      const inotify_event* event = (const inotify_event*)p;
+      p += sizeof(inotify_event) + event->len;
+
+      std::map<Int_t, std::set<TString>>::const_iterator it =
+          fWatches.find(event->wd);
+      if (it == fWatches.end() || !event->len) continue;
+      TString name = event->name;
+      if (it->second.count(name) || name.EndsWith(".rc")) files = kTRUE;
+    }
+  }
+
+  ReadFifo(values);
+}
+
+void CmdLineWatch::ReadFifo(KeyValues& values) {
+  if (fFifo < 0) return;
+
+  char buf[4096];
+  ssize_t len;
+  while ((len = read(fFifo, buf, sizeof(buf))) > 0)
+    fPending.Append(buf, len);
+
+  // only complete lines are taken, the rest waits for the next read
+  Ssiz_t eol;
+  while ((eol = fPending.Index("\n")) >= 0) {
+    TString line = fPending(0, eol);
+    fPending.Remove(0, eol + 1);
+
+    line = line.Strip(TString::kBoth);
+    if (line.IsNull() || line.BeginsWith("#")) continue;
+    Ssiz_t eq = line.Index("=");
+    if (eq <= 0) {
+      std::cerr << "CmdLineWatch: malformed line '" << line << "'"
+                << std::endl;
+      continue;
+    }
+
+    TString key = line(0, eq);
+    TString value = line(eq + 1, line.Length());
+    key = key.Strip(TString::kBoth);
+    value = value.Strip(TString::kBoth);
+    if (!key.BeginsWith("CmdLine.") && !key.BeginsWith("+CmdLine."))
+      key.Insert(key.BeginsWith("+") ? 1 : 0, "CmdLine.");
+    values.push_back(std::make_pair(key, value));
+  }
+}
@@ -0,0 +1,78 @@
+/******************************************************************************
+ *
+ * $Id$
+ *
+ * Environment:
+ *    Software development for ANKE detector system at COSY
+ *
+ * Author List:
+ *    Rafał Lalik                 Modifications, creation of CmdLineArgs library
+ *
+ * Copyright Information:
+ *    Copyright (C) 2018          Rafał Lalik, Jagiellonian University Kraków
+ *
+ *****************************************************************************/
+
+/*!
+  \file   CmdLineWatch.hh
+  \brief  Applies changes of the rc files and values sent to a FIFO
+
+  The directories of the rc files read by a context, extra rc files
+  included, are watched with inotify. Lines "key=value" written to a named
+  pipe set values in the runtime layer, "CmdLine." is prepended to keys
+  without it. Poll() collects the changes arriving within the latency into
+  one batch and applies it with CmdLineConfig::Update().
+
+  \author Rafał Lalik
+  \date   2026-10-19
+*/
+
+#ifndef _CMDLINEWATCH_HH
+#define _CMDLINEWATCH_HH
+
+#include <map>
+#include <set>
+
+#include <TString.h>
+
+#include "CmdLineConfig.hh"
+
+class CmdLineWatch {
+public:
+  CmdLineWatch(CmdLineConfig* config = nullptr);
+  virtual ~CmdLineWatch();
+
+  /// Watches the rc files the context has read.
+  Bool_t Start();
+  /// Creates the named pipe if it does not exist and reads values from it.
+  Bool_t OpenFifo(const char* path);
+  /// Waits for changes and applies them in one batch. Returns the number of
+  /// changed keys, 0 if nothing arrived within the timeout (-1 waits).
+  Int_t Poll(Int_t timeout_ms);
+
+  /// Time to wait for further changes of the same batch, 50 ms by default.
+  void SetLatency(Int_t latency_ms) { fLatency = latency_ms; }
+
+  Int_t GetFd() const { return fInotify; }
+  Int_t GetFifoFd() const { return fFifo; }
+
+private:
+  CmdLineWatch(const CmdLineWatch&) = delete;
+  CmdLineWatch& operator=(const CmdLineWatch&) = delete;
+
+  void Watch();
+  Bool_t Wait(Int_t timeout_ms);
+  void Collect(Bool_t& files, KeyValues& values);
+  void ReadFifo(KeyValues& values);
+
+  CmdLineConfig* fConfig;
+  Int_t fInotify;          // inotify instance, -1 if not started
+  Int_t fFifo;             // read end of the pipe, -1 if not open
+  Int_t fFifoWriter;       // keeps the pipe open between writers
+  TString fFifoPath;       // removed with the watcher if created by it
+  TString fPending;        // incomplete line read from the pipe
+  Int_t fLatency;
+  std::map<Int_t, std::set<TString>> fWatches; // files of the directories
+};
+
+#endif
@@ -7,5 +7,6 @@
 #pragma link C++ class CmdLineConfig;
 #pragma link C++ class CmdLineOption;
 #pragma link C++ class CmdLineArg;
+#pragma link C++ class CmdLineState+;
 
 #endif
@@ -0,0 +1,100 @@
+#include <CmdLineConfig.hh>
+
+#include <TNamed.h>
+#include <TString.h>
+
+#include <cstdlib>
+#include <iostream>
+#include <list>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <malloc.h>
+
+// Heap memory taken by options expanded for many objects. The layout used
+// before, with name, tag, help and all defaults in every option and copies
+// of the name in the map and list of options, is rebuilt for comparison.
+
+static size_t HeapBytes() {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || __GLIBC_MINOR__ >= 33)
+  struct mallinfo2 mi = mallinfo2();
+#else
+  struct mallinfo mi = mallinfo();
+#endif
+  return (size_t)mi.uordblks + (size_t)mi.hblkhd;
+}
+
+struct LegacyOption : public TObject {
+  TString fName;
+  TString fCmdArg;
+  TString fHelp;
+  Int_t fDefInt;
+  Double_t fDefDouble;
+  TString fDefString;
+  Int_t fType;
+  void (*fFunction)();
+  void* fConfig;
+};
+
+int main(int argc, char** argv) {
+  Int_t nobjects = argc > 1 ? atoi(argv[1]) : 2500;
+
+  CmdLineOption gain("Gain", "", "", 1.0);
+  CmdLineOption threshold("Threshold", "", "", 20);
+  CmdLineOption pedestal("Pedestal", "", "", 0.0);
+  CmdLineOption enabled("Enabled", "", "", true);
+  CmdLineOption* templates[] = {&gain, &threshold, &pedestal, &enabled};
+  const char* params[] = {"Gain", "Threshold", "Pedestal", "Enabled"};
+  const Int_t nparams = 4;
+
+  std::vector<TNamed*> objects;
+  for (Int_t i = 0; i < nobjects; ++i) {
+    TString name = TString::Format("Layer%d.Strip%03d", i / 1000, i % 1000);
+    objects.push_back(new TNamed(name, ""));
+  }
+  size_t noptions = (size_t)nobjects * nparams;
+
+  size_t before = HeapBytes();
+  {
+    std::map<TString, LegacyOption*> opts;
+    std::list<std::string> names;
+    for (Int_t i = 0; i < nobjects; ++i)
+      for (Int_t p = 0; p < nparams; ++p) {
+        LegacyOption* opt = new LegacyOption;
+        opt->fName = TString(objects[i]->ClassName()) + "." +
+                     objects[i]->GetName() + "." + params[p];
+        opt->fDefInt = 0;
+        opt->fDefDouble = 0.;
+        opt->fType = 0;
+        opt->fFunction = nullptr;
+        opt->fConfig = nullptr;
+        opts[opt->fName] = opt;
+        names.push_back(opt->fName.Data());
+      }
+    size_t legacy = HeapBytes() - before;
+    std::cout << "expanded options: " << noptions << std::endl;
+    std::cout << "before: " << (Double_t)legacy / noptions
+              << " bytes per option" << std::endl;
+
+    std::map<TString, LegacyOption*>::iterator it = opts.begin();
+    for (; it != opts.end(); ++it)
+      delete it->second;
+  }
+
+  {
+    CmdLineConfig context(CmdLineConfig::instance());
+    CmdLineConfig::Scope scope(&context);
+    size_t empty = HeapBytes();
+    for (Int_t i = 0; i < nobjects; ++i)
+      for (Int_t p = 0; p < nparams; ++p)
+        templates[p]->Expand(objects[i]);
+    size_t compact = HeapBytes() - empty;
+    std::cout << "after:  " << (Double_t)compact / noptions
+              << " bytes per option" << std::endl;
+  }
+
+  for (size_t i = 0; i < objects.size(); ++i)
+    delete objects[i];
+  return EXIT_SUCCESS;
+}
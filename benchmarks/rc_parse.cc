@@ -0,0 +1,75 @@
+#include <CmdLineRcFile.hh>
+
+#include <TEnv.h>
+#include <TString.h>
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Throughput of reading rc files with TEnv::ReadFile() and CmdLineRcFile,
+// on a generated file of per-channel settings.
+
+typedef std::chrono::steady_clock Clock;
+
+static Double_t Seconds(Clock::time_point start) {
+  return std::chrono::duration<Double_t>(Clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+  Int_t nlines = argc > 1 ? atoi(argv[1]) : 200000;
+  Int_t nrepeat = argc > 2 ? atoi(argv[2]) : 5;
+
+  TString path = TString::Format("/tmp/cmdline-bench-%d.rc", (int)getpid());
+  FILE* f = fopen(path, "w");
+  fprintf(f, "# generated by rc_parse\n");
+  for (Int_t i = 0; i < nlines; ++i) {
+    if (i % 100 == 0) fprintf(f, "\n# layer %d\n", i / 100);
+    fprintf(f, "CmdLine.Det.Layer%d.Ch%02d.%s:   %g\n", i / 100, i % 100,
+            i % 2 ? "Gain" : "Threshold", 0.5 + i);
+  }
+  fclose(f);
+
+  struct stat st;
+  stat(path, &st);
+  Double_t mb = st.st_size / 1e6;
+  std::cout << "file: " << mb << " MB, " << nlines << " records" << std::endl;
+
+  Double_t troot = 0, tparse = 0, tread = 0;
+  for (Int_t r = 0; r < nrepeat; ++r) {
+    Clock::time_point start = Clock::now();
+    {
+      TEnv env;
+      env.ReadFile(path, kEnvUser);
+    }
+    troot += Seconds(start);
+
+    start = Clock::now();
+    {
+      CmdLineRcFile file;
+      file.Read(path);
+    }
+    tparse += Seconds(start);
+
+    start = Clock::now();
+    {
+      TEnv env;
+      CmdLineRcFile::ReadFile(&env, path, kEnvUser);
+    }
+    tread += Seconds(start);
+  }
+
+  std::cout << "TEnv::ReadFile:          " << mb * nrepeat / troot << " MB/s"
+            << std::endl;
+  std::cout << "CmdLineRcFile parsing:   " << mb * nrepeat / tparse << " MB/s"
+            << std::endl;
+  std::cout << "CmdLineRcFile::ReadFile: " << mb * nrepeat / tread << " MB/s"
+            << std::endl;
+
+  unlink(path);
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,80 @@
+#include <CmdLineBatch.hh>
+#include <CmdLineConfig.hh>
+
+#include <TSystem.h>
+
+#include <cstdlib>
+#include <iostream>
+
+// Entry point exported by the user library:
+//   extern "C" void CmdLineJob(CmdLineConfig* view, size_t job);
+typedef void (*JobEntry_t)(CmdLineConfig*, size_t);
+
+static void usage(const char* prog) {
+  std::cout << "Usage: " << prog << " [-j threads] [-n name] joblist library"
+            << " [symbol]" << std::endl
+            << "  -j threads          number of worker threads" << std::endl
+            << "  -n name             program name passed as argv[0]"
+            << std::endl
+            << "   joblist            file with one command line per job"
+            << std::endl
+            << "   library            library providing the job function"
+            << std::endl
+            << "   symbol             job function name (CmdLineJob)"
+            << std::endl;
+}
+
+int main(int argc, char** argv) {
+  UInt_t nthreads = 0;
+  const char* progname = "job";
+  std::vector<const char*> pos;
+
+  for (int i = 1; i < argc; ++i) {
+    TString opt = argv[i];
+    if (opt == "-h") {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else if (opt == "-j" && i + 1 < argc) {
+      nthreads = atoi(argv[++i]);
+    } else if (opt == "-n" && i + 1 < argc) {
+      progname = argv[++i];
+    } else {
+      pos.push_back(argv[i]);
+    }
+  }
+
+  if (pos.size() < 2 || pos.size() > 3) {
+    usage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  // options and arguments of the jobs are registered by the library
+  if (gSystem->Load(pos[1]) < 0) {
+    std::cerr << "Error: cannot load library " << pos[1] << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const char* symbol = pos.size() > 2 ? pos[2] : "CmdLineJob";
+  JobEntry_t entry = (JobEntry_t)gSystem->DynFindSymbol(pos[1], symbol);
+  if (!entry) {
+    std::cerr << "Error: symbol " << symbol << " not found in " << pos[1]
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  CmdLineBatch batch;
+  batch.SetProgramName(progname);
+  if (batch.ReadJobList(pos[0]) < 0) return EXIT_FAILURE;
+
+  std::cout << "Running " << batch.GetNJobs() << " jobs" << std::endl;
+  Int_t failed = batch.Run(
+      [entry](CmdLineConfig& view, size_t job) { entry(&view, job); },
+      nthreads);
+  if (failed) {
+    std::cerr << "Error: " << failed << " of " << batch.GetNJobs()
+              << " jobs failed" << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,90 @@
+#include <CmdLineConfig.hh>
+#include <CmdLineShm.hh>
+
+#include <TEnv.h>
+
+#include <cerrno>
+#include <csignal>
+#include <cstdlib>
+#include <iostream>
+
+#include <poll.h>
+
+static volatile sig_atomic_t gReload = 0;
+static volatile sig_atomic_t gQuit = 0;
+
+static void on_signal(int sig) {
+  if (sig == SIGHUP)
+    gReload = 1;
+  else
+    gQuit = 1;
+}
+
+static Bool_t publish(CmdLineConfig* cfg, CmdLineShm& shm) {
+  TEnv env("");
+  cfg->Merge(&env);
+  return shm.Publish(&env);
+}
+
+static void usage(const char* prog) {
+  std::cout << "Usage: " << prog << " [-n segment] [rcname]" << std::endl
+            << "  -n segment          shared memory segment (cmdline)"
+            << std::endl
+            << "   rcname             name of the rc files (.cmdlinerc)"
+            << std::endl
+            << std::endl
+            << "Clients use the segment if CMDLINE_SHM is set to its name."
+            << " SIGHUP reads the rc files again." << std::endl;
+}
+
+int main(int argc, char** argv) {
+  const char* segment = "cmdline";
+  const char* rcname = nullptr;
+
+  for (int i = 1; i < argc; ++i) {
+    TString opt = argv[i];
+    if (opt == "-h") {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else if (opt == "-n" && i + 1 < argc) {
+      segment = argv[++i];
+    } else if (!rcname) {
+      rcname = argv[i];
+    } else {
+      usage(argv[0]);
+      return EXIT_FAILURE;
+    }
+  }
+
+  // the server itself must read the files
+  unsetenv("CMDLINE_SHM");
+  CmdLineConfig* cfg = CmdLineConfig::instance(rcname);
+
+  CmdLineShm shm(segment);
+  if (!publish(cfg, shm) || !shm.Listen()) return EXIT_FAILURE;
+  std::cout << "Published " << shm.GetNRecords() << " records in "
+            << shm.GetName() << ", version " << shm.GetVersion() << std::endl;
+
+  signal(SIGHUP, on_signal);
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  while (!gQuit) {
+    pollfd pfd = {shm.GetListenSocket(), POLLIN, 0};
+    int n = poll(&pfd, 1, 1000);
+    if (n < 0 && errno != EINTR) break;
+    if (n > 0) shm.Accept();
+
+    if (gReload) {
+      gReload = 0;
+      cfg->Reload();
+      if (publish(cfg, shm)) {
+        shm.Notify();
+        std::cout << "Published version " << shm.GetVersion() << std::endl;
+      }
+    }
+  }
+
+  shm.Unlink();
+  return EXIT_SUCCESS;
+}
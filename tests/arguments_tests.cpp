@@ -0,0 +1,106 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <CmdLineConfig.hh>
+
+#include <TString.h>
+
+class ArgumentsCase : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(ArgumentsCase);
+  CPPUNIT_TEST(TypedValues);
+  CPPUNIT_TEST(GreedyDoubles);
+  CPPUNIT_TEST(Ranges);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  CmdLineArg *arg1, *greedy, *arg2;
+
+public:
+  virtual void setUp() override {
+    arg1 = new CmdLineArg("first", "first", CmdLineArg::kInt);
+    greedy = new CmdLineArg("", "runs", CmdLineArg::kInt);
+    arg2 = new CmdLineArg("second", "second", CmdLineArg::kDouble);
+  }
+  virtual void tearDown() override {
+    CmdLineConfig::instance()->ClearOptions();
+  }
+
+protected:
+  void TypedValues() {
+    const char* argv[] = {"./prog", "7", "1", "2", "3,4", "+5", "2.5e-1"};
+    CmdLineConfig::instance()->ReadCmdLine(sizeof(argv) / sizeof(char*),
+                                           (char**)argv);
+
+    CPPUNIT_ASSERT_EQUAL(7, CmdLineArg::GetIntValue("first"));
+    CPPUNIT_ASSERT_EQUAL(0.25, CmdLineArg::GetDoubleValue("second"));
+
+    const std::vector<Int_t>& runs = CmdLineConfig::GetGreedyIntArguments();
+    CPPUNIT_ASSERT_EQUAL(size_t(5), runs.size());
+    for (int i = 0; i < 5; ++i)
+      CPPUNIT_ASSERT_EQUAL(i + 1, runs[i]);
+    CPPUNIT_ASSERT_EQUAL(size_t(4),
+                         CmdLineConfig::GetGreedyArguments().size());
+    CPPUNIT_ASSERT_EQUAL(size_t(0),
+                         CmdLineConfig::GetGreedyDoubleArguments().size());
+  }
+
+  void GreedyDoubles() {
+    CmdLineConfig view(CmdLineConfig::instance());
+    CmdLineConfig::Scope scope(&view);
+    CmdLineArg thresholds("", "thresholds", CmdLineArg::kDouble);
+
+    const char* argv[] = {"./prog", "0.5", "1e3", "x", "-2"};
+    view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+
+    const std::vector<Double_t>& values =
+        CmdLineConfig::GetGreedyDoubleArguments();
+    CPPUNIT_ASSERT_EQUAL(size_t(3), values.size());
+    CPPUNIT_ASSERT_EQUAL(0.5, values[0]);
+    CPPUNIT_ASSERT_EQUAL(1000.0, values[1]);
+    CPPUNIT_ASSERT_EQUAL(-2.0, values[2]);
+  }
+
+  void Ranges() {
+    const char* argv[] = {"./prog",      "7",   "10000-19999", "20500",
+                          "21000-21999:10", "5:6", "0.5"};
+    CmdLineConfig::instance()->ReadCmdLine(sizeof(argv) / sizeof(char*),
+                                           (char**)argv);
+
+    const CmdLineRange& runs = CmdLineConfig::GetGreedyRange();
+    CPPUNIT_ASSERT_EQUAL(ULong64_t(10000 + 1 + 100 + 2), runs.size());
+    CPPUNIT_ASSERT_EQUAL(size_t(4), runs.GetIntervals().size());
+    CPPUNIT_ASSERT_EQUAL(10000, runs.At(0));
+    CPPUNIT_ASSERT_EQUAL(20500, runs.At(10000));
+    CPPUNIT_ASSERT_EQUAL(21010, runs.At(10002));
+    CPPUNIT_ASSERT_EQUAL(6, runs.At(10102));
+
+    CPPUNIT_ASSERT(runs.Contains(15000));
+    CPPUNIT_ASSERT(runs.Contains(20500));
+    CPPUNIT_ASSERT(runs.Contains(21990));
+    CPPUNIT_ASSERT(runs.Contains(5));
+    CPPUNIT_ASSERT(!runs.Contains(21995));
+    CPPUNIT_ASSERT(!runs.Contains(20000));
+    CPPUNIT_ASSERT(!runs.Contains(22000));
+
+    ULong64_t n = 0;
+    Int_t last = 0;
+    for (CmdLineRange::Iterator it = runs.begin(); it != runs.end(); ++it) {
+      last = *it;
+      ++n;
+    }
+    CPPUNIT_ASSERT_EQUAL(runs.size(), n);
+    CPPUNIT_ASSERT_EQUAL(6, last);
+
+    const std::vector<Int_t>& all = CmdLineConfig::GetGreedyIntArguments();
+    CPPUNIT_ASSERT_EQUAL(size_t(runs.size()), all.size());
+    CPPUNIT_ASSERT_EQUAL(19999, all[9999]);
+
+    CmdLineRange range;
+    CPPUNIT_ASSERT(!range.Parse("1-5,8-3"));
+    CPPUNIT_ASSERT(range.empty());
+    CPPUNIT_ASSERT(range.Parse("1 2 3 5-9:2"));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), range.GetIntervals().size());
+    CPPUNIT_ASSERT_EQUAL(ULong64_t(6), range.size());
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ArgumentsCase);
@@ -3,8 +3,13 @@
 #include <CmdLineConfig.hh>
 
 #include <TH1I.h>
+#include <TList.h>
 #include <TString.h>
 
+#include <iostream>
+#include <sstream>
+#include <thread>
+
 class BasicCase : public CppUnit::TestFixture {
   CPPUNIT_TEST_SUITE(BasicCase);
   CPPUNIT_TEST(Principles);
@@ -13,7 +18,12 @@ class BasicCase : public CppUnit::TestFixture {
   CPPUNIT_TEST(Values);
   CPPUNIT_TEST(Defaults);
   CPPUNIT_TEST(Expand);
+  CPPUNIT_TEST(ExpandMany);
+  CPPUNIT_TEST(Tree);
   CPPUNIT_TEST(Arrays);
+  CPPUNIT_TEST(Validation);
+  CPPUNIT_TEST(Callbacks);
+  CPPUNIT_TEST(Generations);
   CPPUNIT_TEST(Others);
   CPPUNIT_TEST_SUITE_END();
 
@@ -213,7 +223,6 @@ protected:
 
       const Greedy& gargs = CmdLineConfig::instance()->GetGreedyArguments();
       CPPUNIT_ASSERT_EQUAL(0, (int)gargs.size());
-      CPPUNIT_ASSERT_EQUAL(TString("positional2"), TString(gargs[0]->GetStringValue()));
     }
   }
 
@@ -265,6 +274,21 @@ protected:
     CPPUNIT_ASSERT_EQUAL(std::string("pi"),
                          std::string(string_val->GetStringValue()));
 
+    {
+      // trailing blanks are stripped when reading, later values of the
+      // parent are still seen
+      CmdLineConfig* cfg = CmdLineConfig::instance();
+      CmdLineConfig::Override values(cfg);
+      CmdLineConfig view(cfg);
+      CmdLineConfig::Scope scope(&view);
+      cfg->SetValue("CmdLine.StringArg", "hello  ");
+      CPPUNIT_ASSERT_EQUAL(std::string("hello"),
+                           std::string(string_val->GetStringValue()));
+      cfg->SetValue("CmdLine.StringArg", "world");
+      CPPUNIT_ASSERT_EQUAL(std::string("world"),
+                           std::string(string_val->GetStringValue()));
+    }
+
     const Positional& pargs =
         CmdLineConfig::instance()->GetPositionalArguments();
     CPPUNIT_ASSERT_EQUAL(2, (int)pargs.size());
@@ -331,6 +355,136 @@ protected:
     CPPUNIT_ASSERT_EQUAL(
         std::string("pi"),
         std::string(hist1_string_val->GetDefaultStringValue()));
+    CPPUNIT_ASSERT_EQUAL(0.0, hist1_int_val->GetDefaultDoubleValue());
+    CPPUNIT_ASSERT_EQUAL(0, hist1_double_val->GetDefaultIntValue());
+
+    // expanded once, without tag and help
+    CPPUNIT_ASSERT_EQUAL(hist1_int_val, int_val->Expand(h1));
+    CPPUNIT_ASSERT_EQUAL(hist1_int_val,
+                         CmdLineConfig::FindOption("TH1I.hist1.IntegerArg"));
+    CPPUNIT_ASSERT_EQUAL(std::string(""),
+                         std::string(hist1_int_val->GetHelp()));
+
+    CmdLineConfig::instance()->SetValue("CmdLine.TH1I.hist1.IntegerArg", "5");
+    CPPUNIT_ASSERT_EQUAL(5, hist1_int_val->GetIntValue());
+    CPPUNIT_ASSERT_EQUAL(13, int_val->GetIntValue());
+
+    // the expansion cached for the object follows its name
+    h1->SetName("hist2");
+    CmdLineOption* hist2_int_val = int_val->Expand(h1);
+    CPPUNIT_ASSERT(hist2_int_val != hist1_int_val);
+    CPPUNIT_ASSERT_EQUAL(hist2_int_val,
+                         CmdLineConfig::FindOption("TH1I.hist2.IntegerArg"));
+    CPPUNIT_ASSERT_EQUAL(hist2_int_val, int_val->Expand(h1));
+    h1->SetName("hist1");
+    CPPUNIT_ASSERT_EQUAL(5, int_val->Expand(h1)->GetIntValue());
+
+    // every thread caches on its own, the option is the same
+    CmdLineOption* other = nullptr;
+    std::thread thread([&] { other = int_val->Expand(h1); });
+    thread.join();
+    CPPUNIT_ASSERT_EQUAL(hist1_int_val, other);
+
+    // deleting an expanded option removes it, the arena keeps the memory
+    delete hist2_int_val;
+    CPPUNIT_ASSERT(!CmdLineConfig::FindOption("TH1I.hist2.IntegerArg"));
+    CmdLineState state;
+    CmdLineConfig::instance()->SaveState(state);
+    CPPUNIT_ASSERT(!state.GetOptionValue("TH1I.hist2.IntegerArg"));
+    CPPUNIT_ASSERT_EQUAL(std::string("5"), std::string(state.GetOptionValue(
+                                               "TH1I.hist1.IntegerArg")));
+    CmdLineConfig::ClearValues();
+    delete h1;
+  }
+
+  void ExpandMany() {
+    TList hists;
+    hists.SetOwner();
+    for (int i = 0; i < 3; ++i)
+      hists.Add(new TH1I(TString::Format("h%d", i), "", 10, 0, 10));
+    CmdLineOption* known = int_val->Expand(hists.At(1));
+
+    CmdLineConfig* cfg = CmdLineConfig::instance();
+    cfg->SetValue("CmdLine.TH1I.h2.IntegerArg", "7");
+    cfg->SetValue("CmdLine.TH1I.*.DoubleArg", "2.5");
+    cfg->SetValue("CmdLine.TH1I.h0.IntegerArg", "x7");
+
+    // the malformed value is reported, the default used
+    std::ostringstream err;
+    std::streambuf* cerr = std::cerr.rdbuf(err.rdbuf());
+    std::vector<CmdLineOption*> opts =
+        CmdLineOption::Expand(&hists, {int_val, double_val}, 2);
+    std::cerr.rdbuf(cerr);
+    CPPUNIT_ASSERT_EQUAL(std::string("CmdLineOption: invalid value 'x7' of "
+                                     "TH1I.h0.IntegerArg at configuration, "
+                                     "using default\n"),
+                         err.str());
+    CPPUNIT_ASSERT_EQUAL(6, (int)opts.size());
+    CPPUNIT_ASSERT_EQUAL(known, opts[2]);
+    CPPUNIT_ASSERT_EQUAL(opts[4],
+                         CmdLineConfig::FindOption("TH1I.h2.IntegerArg"));
+    CPPUNIT_ASSERT_EQUAL(13, opts[0]->GetIntValue());
+    CPPUNIT_ASSERT_EQUAL(7, opts[4]->GetIntValue());
+    for (int i = 1; i < 6; i += 2)
+      CPPUNIT_ASSERT_EQUAL(2.5, opts[i]->GetDoubleValue());
+
+    // a range with repeated objects
+    std::vector<TH1I*> range = {(TH1I*)hists.At(0), (TH1I*)hists.At(0)};
+    std::vector<CmdLineOption*> again =
+        CmdLineOption::Expand(range.begin(), range.end(), {bool_val});
+    CPPUNIT_ASSERT(again[0] != nullptr);
+    CPPUNIT_ASSERT_EQUAL(again[0], again[1]);
+    CPPUNIT_ASSERT_EQUAL(again[0], bool_val->Expand(hists.At(0)));
+
+    CmdLineConfig::ClearValues();
+  }
+
+  void Tree() {
+    TList hists;
+    hists.SetOwner();
+    for (int i = 0; i < 3; ++i)
+      hists.Add(new TH1I(TString::Format("h%d", i), "", 10, 0, 10));
+    hists.Add(new TH1I("h10", "", 10, 0, 10));
+    std::vector<CmdLineOption*> opts =
+        CmdLineOption::Expand(&hists, {int_val, double_val});
+
+    CmdLineConfig* cfg = CmdLineConfig::instance();
+    cfg->SetValue("CmdLine.TH1I.h1.IntegerArg", "7");
+    cfg->SetValue("CmdLine.TH1I.*.DoubleArg", "2.5");
+
+    // "h10" is not below "h1"
+    CmdLineSpan<CmdLineTree::Entry> h1 = cfg->GetOptions("TH1I.h1");
+    CPPUNIT_ASSERT_EQUAL(size_t(2), h1.size());
+    CPPUNIT_ASSERT(h1[0].fName == "TH1I.h1.DoubleArg");
+    CPPUNIT_ASSERT_EQUAL(opts[3], h1[0].fOption);
+    CPPUNIT_ASSERT_EQUAL(std::string("2.5"), std::string(h1[0].fValue));
+    CPPUNIT_ASSERT_EQUAL(opts[2], h1[1].fOption);
+    CPPUNIT_ASSERT_EQUAL(std::string("7"), std::string(h1[1].fValue));
+    CPPUNIT_ASSERT_EQUAL(size_t(1),
+                         cfg->GetOptionTree().Count("TH1I.h10.IntegerArg"));
+    CPPUNIT_ASSERT_EQUAL(size_t(0), cfg->GetOptionTree().Count("TH1I.h3"));
+
+    const CmdLineTree& options = cfg->GetOptionTree();
+    CPPUNIT_ASSERT_EQUAL(size_t(8), options.Count("TH1I"));
+    CmdLineSpan<CmdLineTree::Node> children = options.GetChildren("TH1I");
+    CPPUNIT_ASSERT_EQUAL(size_t(4), children.size());
+    CPPUNIT_ASSERT(children[1].fName == "h1");
+    CPPUNIT_ASSERT(children[2].fPath == "TH1I.h10");
+    CPPUNIT_ASSERT_EQUAL(size_t(2), options.GetEntries(children[2]).size());
+
+    CmdLineSpan<CmdLineTree::Node> keys = cfg->GetKeyTree().GetChildren(
+        "CmdLine.TH1I");
+    CPPUNIT_ASSERT_EQUAL(size_t(2), keys.size());
+    CPPUNIT_ASSERT(keys[0].fName == "*");
+    CPPUNIT_ASSERT(keys[1].fName == "h1");
+
+    // the index follows changes
+    cfg->SetValue("CmdLine.TH1I.h2.IntegerArg", "8");
+    CPPUNIT_ASSERT_EQUAL(size_t(3), cfg->GetKeys("CmdLine.TH1I").size());
+    CPPUNIT_ASSERT_EQUAL(std::string("8"),
+                         std::string(cfg->GetOptions("TH1I.h2")[1].fValue));
+
+    CmdLineConfig::ClearValues();
   }
 
   void Arrays() {
@@ -382,6 +536,122 @@ protected:
     }
   }
 
+  void Validation() {
+    {
+      const char* argv[] = {"./prog", "-int", "+7", "-double", "-2.5e1",
+                            "-bool", "yes", "pos1", "pos2"};
+      CmdLineConfig::instance()->ReadCmdLine(sizeof(argv) / sizeof(char*),
+                                             (char**)argv);
+      CPPUNIT_ASSERT_EQUAL(7, CmdLineOption::GetIntValue("IntegerArg"));
+      CPPUNIT_ASSERT_EQUAL(-25.0, CmdLineOption::GetDoubleValue("DoubleArg"));
+      CPPUNIT_ASSERT_EQUAL(true, CmdLineOption::GetBoolValue("BoolArg"));
+    }
+
+    {
+      const char* argv[] = {"./prog", "-int",  "12abc", "-double",
+                            "1.5,x", "pos1", "pos2"};
+      CmdLineConfig::instance()->ReadCmdLine(sizeof(argv) / sizeof(char*),
+                                             (char**)argv);
+      CPPUNIT_ASSERT_EQUAL(13, CmdLineOption::GetIntValue("IntegerArg"));
+      CPPUNIT_ASSERT_EQUAL(0, CmdLineOption::GetArraySize("IntegerArg"));
+      CPPUNIT_ASSERT_EQUAL(3.1415,
+                           CmdLineOption::GetDoubleValue("DoubleArg"));
+      CPPUNIT_ASSERT_EQUAL(0, CmdLineOption::GetArraySize("DoubleArg"));
+    }
+
+    CmdLineConfig::ClearValues();
+  }
+
+  void Generations() {
+    CmdLineConfig view(CmdLineConfig::instance());
+    ULong64_t start = view.GetGeneration();
+
+    const char* argv[] = {"./prog", "-int", "5", "pos1", "pos2"};
+    view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+    ULong64_t read = view.GetGeneration();
+    CPPUNIT_ASSERT(read > start);
+    CPPUNIT_ASSERT_EQUAL(read, view.GetModified(int_val));
+    CPPUNIT_ASSERT(view.GetModified(double_val) < read);
+
+    std::vector<TString> keys;
+    CPPUNIT_ASSERT(view.GetChanges(start, keys));
+    CPPUNIT_ASSERT_EQUAL(size_t(1), keys.size());
+    CPPUNIT_ASSERT_EQUAL(TString("CmdLine.IntegerArg"), keys[0]);
+
+    view.SetValue("CmdLine.DoubleArg", "2.5");
+    view.SetValue("Other.Key", "x");
+    keys.clear();
+    CPPUNIT_ASSERT(view.GetChanges(read, keys));
+    CPPUNIT_ASSERT_EQUAL(size_t(2), keys.size());
+    CPPUNIT_ASSERT_EQUAL(TString("Other.Key"), keys[0]);
+    CPPUNIT_ASSERT(view.GetModified(double_val) > read);
+
+    {
+      // converted values are kept until their key or a pattern changed
+      CmdLineConfig::Scope scope(&view);
+      CmdLineOption opt("Gen.Arg", "", "", 1);
+      CPPUNIT_ASSERT_EQUAL(1, opt.GetIntValue());
+      CPPUNIT_ASSERT_EQUAL(2.5, double_val->GetDoubleValue());
+      view.SetValue("Other.Key", "y");
+      CPPUNIT_ASSERT_EQUAL(1, opt.GetIntValue());
+      view.SetValue("CmdLine.*.Arg", "4");
+      CPPUNIT_ASSERT_EQUAL(4, opt.GetIntValue());
+      CPPUNIT_ASSERT_EQUAL(2.5, double_val->GetDoubleValue());
+      view.SetValue("CmdLine.Gen.Arg", "6");
+      CPPUNIT_ASSERT_EQUAL(6, opt.GetIntValue());
+    }
+
+    // the journal is bounded, older changes must be taken as unknown
+    view.SetJournalSize(1);
+    keys.clear();
+    CPPUNIT_ASSERT(!view.GetChanges(read, keys));
+    keys.clear();
+    view.Invalidate();
+    CPPUNIT_ASSERT(!view.GetChanges(read, keys));
+    CPPUNIT_ASSERT_EQUAL(view.GetGeneration(), view.GetModified(int_val));
+  }
+
+  void Callbacks() {
+    int calls = 0, any_calls = 0;
+    ChangedOptions seen;
+    Int_t id = CmdLineConfig::instance()->AddCallback(
+        [&](const ChangedOptions& changed) {
+          ++calls;
+          seen = changed;
+          // all values are already applied when the callback runs
+          CPPUNIT_ASSERT_EQUAL(7, int_val->GetIntValue());
+          CPPUNIT_ASSERT_EQUAL(1.5, double_val->GetDoubleValue());
+        },
+        {int_val, double_val});
+    Int_t any_id = CmdLineConfig::instance()->AddCallback(
+        [&](const ChangedOptions& changed) { any_calls += changed.size(); });
+
+    {
+      const char* argv[] = {"./prog", "-int",    "7",    "-double",
+                            "1.5",    "-string", "text", "-int",
+                            "7",      "pos1",    "pos2"};
+      CmdLineConfig::instance()->ReadCmdLine(sizeof(argv) / sizeof(char*),
+                                             (char**)argv);
+    }
+
+    CPPUNIT_ASSERT_EQUAL(1, calls);
+    CPPUNIT_ASSERT_EQUAL(2, (int)seen.size());
+    CPPUNIT_ASSERT(seen[0] == int_val);
+    CPPUNIT_ASSERT(seen[1] == double_val);
+    CPPUNIT_ASSERT_EQUAL(3, any_calls);
+
+    {
+      const char* argv[] = {"./prog", "-string", "other", "pos1", "pos2"};
+      CmdLineConfig::instance()->ReadCmdLine(sizeof(argv) / sizeof(char*),
+                                             (char**)argv);
+    }
+    CPPUNIT_ASSERT_EQUAL(1, calls);
+    CPPUNIT_ASSERT_EQUAL(4, any_calls);
+
+    CmdLineConfig::instance()->RemoveCallback(id);
+    CmdLineConfig::instance()->RemoveCallback(any_id);
+  }
+
   void Others() {}
 };
 
@@ -0,0 +1,286 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <CmdLineBatch.hh>
+#include <CmdLineConfig.hh>
+
+#include <TEnv.h>
+#include <TString.h>
+
+#include <atomic>
+#include <thread>
+
+class ContextCase : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(ContextCase);
+  CPPUNIT_TEST(Isolation);
+  CPPUNIT_TEST(Threads);
+  CPPUNIT_TEST(Batch);
+  CPPUNIT_TEST(Layers);
+  CPPUNIT_TEST(Bindings);
+  CPPUNIT_TEST(Routes);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  CmdLineOption* int_val;
+  CmdLineOption* string_val;
+  CmdLineArg* arg1;
+
+  // counts the values written into it
+  struct Writes {
+    std::atomic<Int_t> fN;
+    Writes() : fN(0) {}
+    Writes(const char*) : fN(0) {}
+    Writes& operator=(const Writes&) {
+      ++fN;
+      return *this;
+    }
+  };
+
+public:
+  virtual void setUp() override {
+    int_val = new CmdLineOption("CtxIntArg", "-int", "Int Help message", 13);
+    string_val =
+        new CmdLineOption("CtxStringArg", "-string", "String Help message", "pi");
+    arg1 = new CmdLineArg("arg1", "first", CmdLineArg::kString);
+  }
+  virtual void tearDown() override {
+    CmdLineConfig::instance()->ClearOptions();
+  }
+
+protected:
+  void Isolation() {
+    {
+      const char* argv[] = {"./prog", "-int", "1", "pos"};
+      CmdLineConfig::instance()->ReadCmdLine(sizeof(argv) / sizeof(char*),
+                                             (char**)argv);
+    }
+
+    CmdLineConfig view(CmdLineConfig::instance());
+    {
+      const char* argv[] = {"./prog", "-int", "2", "view"};
+      view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+    }
+
+    CPPUNIT_ASSERT_EQUAL(1, CmdLineOption::GetIntValue("CtxIntArg"));
+    CPPUNIT_ASSERT_EQUAL(TString("pos"),
+                         TString(CmdLineArg::GetStringValue("arg1")));
+
+    {
+      CmdLineConfig::Scope scope(&view);
+      CPPUNIT_ASSERT_EQUAL(2, CmdLineOption::GetIntValue("CtxIntArg"));
+      CPPUNIT_ASSERT_EQUAL(2, int_val->GetIntValue());
+      CPPUNIT_ASSERT_EQUAL(
+          std::string("pi"),
+          std::string(CmdLineOption::GetStringValue("CtxStringArg")));
+      CPPUNIT_ASSERT_EQUAL(TString("view"),
+                           TString(CmdLineArg::GetStringValue("arg1")));
+    }
+
+    CPPUNIT_ASSERT_EQUAL(1, CmdLineOption::GetIntValue("CtxIntArg"));
+  }
+
+  void Threads() {
+    const int n = 4;
+    int results[n];
+    std::thread workers[n];
+
+    for (int t = 0; t < n; ++t) {
+      workers[t] = std::thread([t, &results] {
+        CmdLineConfig view(CmdLineConfig::instance());
+        TString value = TString::Format("%d", 100 + t);
+        const char* argv[] = {"./prog", "-int", value.Data(), "pos"};
+        view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+
+        CmdLineConfig::Scope scope(&view);
+        results[t] = CmdLineOption::GetIntValue("CtxIntArg");
+      });
+    }
+    for (int t = 0; t < n; ++t)
+      workers[t].join();
+
+    for (int t = 0; t < n; ++t)
+      CPPUNIT_ASSERT_EQUAL(100 + t, results[t]);
+  }
+
+  void Batch() {
+    std::vector<TString> args =
+        CmdLineBatch::SplitArgs("-string 'two words' \"a \\\"b\\\"\" c\\ d");
+    CPPUNIT_ASSERT_EQUAL(4, (int)args.size());
+    CPPUNIT_ASSERT_EQUAL(TString("two words"), args[1]);
+    CPPUNIT_ASSERT_EQUAL(TString("a \"b\""), args[2]);
+    CPPUNIT_ASSERT_EQUAL(TString("c d"), args[3]);
+
+    CmdLineBatch batch;
+    const int n = 16;
+    for (int i = 0; i < n; ++i)
+      batch.AddJob(TString::Format("-int %d file%d.root", i, i));
+    CPPUNIT_ASSERT_EQUAL(n, (int)batch.GetNJobs());
+
+    // bad jobs are skipped, the others run
+    batch.AddJob("-int 1 -h file.root");
+    batch.AddJob("-int 1");
+
+    // variables bound in the default context are not written by the jobs
+    Writes root_int, root_file;
+    CmdLineBinding int_binding = int_val->Bind(root_int);
+    CmdLineBinding file_binding = arg1->Bind(root_file);
+
+    std::vector<int> values(n + 2, -1);
+    std::vector<TString> files(n + 2);
+    Int_t failed = batch.Run(
+        [&](CmdLineConfig& view, size_t job) {
+          values[job] = CmdLineOption::GetIntValue("CtxIntArg");
+          files[job] = CmdLineArg::GetStringValue("arg1");
+        },
+        4);
+
+    CPPUNIT_ASSERT_EQUAL(2, failed);
+    for (int i = 0; i < n; ++i) {
+      CPPUNIT_ASSERT_EQUAL(i, values[i]);
+      CPPUNIT_ASSERT_EQUAL(TString::Format("file%d.root", i), files[i]);
+    }
+    CPPUNIT_ASSERT_EQUAL(-1, values[n]);
+    CPPUNIT_ASSERT_EQUAL(-1, values[n + 1]);
+    CPPUNIT_ASSERT_EQUAL(1, root_int.fN.load());
+    CPPUNIT_ASSERT_EQUAL(1, root_file.fN.load());
+  }
+
+  void Layers() {
+    // values of the other tests are dropped
+    CmdLineConfig::ClearValues();
+    CmdLineConfig view(CmdLineConfig::instance());
+    CmdLineConfig::Scope scope(&view);
+
+    // value of an rc file
+    view.GetLayer(CmdLineConfig::kLayerUser)->SetValue("CmdLine.CtxIntArg",
+                                                       "7");
+    view.Invalidate();
+    CPPUNIT_ASSERT_EQUAL(7, CmdLineOption::GetIntValue("CtxIntArg"));
+    CPPUNIT_ASSERT_EQUAL(std::string("7"),
+                         std::string(int_val->GetStringValue(kTRUE)));
+
+    const char* argv[] = {"./prog", "-int", "3", "pos"};
+    view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+    CPPUNIT_ASSERT_EQUAL(3, CmdLineOption::GetIntValue("CtxIntArg"));
+
+    int changes = 0;
+    view.AddCallback([&changes](const ChangedOptions& changed) {
+      changes += changed.size();
+    });
+    {
+      CmdLineConfig::Override outer(&view);
+      view.SetValue("CmdLine.CtxIntArg", "4");
+      {
+        CmdLineConfig::Override inner(&view);
+        view.SetValue("CmdLine.CtxIntArg", "5");
+        CPPUNIT_ASSERT_EQUAL(size_t(2), view.GetNOverrides());
+        CPPUNIT_ASSERT_EQUAL(5, CmdLineOption::GetIntValue("CtxIntArg"));
+      }
+      CPPUNIT_ASSERT_EQUAL(4, CmdLineOption::GetIntValue("CtxIntArg"));
+    }
+    CPPUNIT_ASSERT_EQUAL(size_t(0), view.GetNOverrides());
+    CPPUNIT_ASSERT_EQUAL(3, CmdLineOption::GetIntValue("CtxIntArg"));
+    CPPUNIT_ASSERT_EQUAL(2, changes);
+
+    // built-in defaults hide the rc files until the next command line
+    CmdLineConfig::RestoreDefaults();
+    CPPUNIT_ASSERT_EQUAL(13, CmdLineOption::GetIntValue("CtxIntArg"));
+    view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+    CPPUNIT_ASSERT_EQUAL(3, CmdLineOption::GetIntValue("CtxIntArg"));
+
+    // the rc files are visible again, then the built-in default
+    CmdLineConfig::ClearValues();
+    CPPUNIT_ASSERT_EQUAL(7, CmdLineOption::GetIntValue("CtxIntArg"));
+    TObject* rec =
+        view.GetLayer(CmdLineConfig::kLayerUser)->Lookup("CmdLine.CtxIntArg");
+    delete view.GetLayer(CmdLineConfig::kLayerUser)->GetTable()->Remove(rec);
+    view.Invalidate();
+    CPPUNIT_ASSERT_EQUAL(13, CmdLineOption::GetIntValue("CtxIntArg"));
+    CPPUNIT_ASSERT_EQUAL(std::string("13"),
+                         std::string(int_val->GetStringValue(kTRUE)));
+  }
+
+  void Bindings() {
+    CmdLineConfig::ClearValues();
+    CmdLineConfig view(CmdLineConfig::instance());
+    CmdLineConfig::Scope scope(&view);
+
+    std::atomic<Int_t> number(0);
+    TString text;
+    TString first;
+    CmdLineBinding number_binding = int_val->Bind(number);
+    CmdLineBinding text_binding = string_val->Bind(text);
+    CmdLineBinding first_binding = arg1->Bind(first);
+    CPPUNIT_ASSERT(number_binding.IsBound());
+    CPPUNIT_ASSERT_EQUAL(13, number.load());
+    CPPUNIT_ASSERT_EQUAL(TString("pi"), text);
+
+    const char* argv[] = {"./prog", "-int", "3", "-string", "e", "pos"};
+    view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+    CPPUNIT_ASSERT_EQUAL(3, number.load());
+    CPPUNIT_ASSERT_EQUAL(TString("e"), text);
+    CPPUNIT_ASSERT_EQUAL(TString("pos"), first);
+
+    // callbacks see the bound variables updated
+    Int_t seen = 0;
+    view.AddCallback(
+        [&seen, &number](const ChangedOptions&) { seen = number.load(); });
+    {
+      CmdLineConfig::Override override(&view);
+      view.SetValue("CmdLine.CtxIntArg", "4");
+      CPPUNIT_ASSERT_EQUAL(4, number.load());
+    }
+    CPPUNIT_ASSERT_EQUAL(3, number.load());
+    CPPUNIT_ASSERT_EQUAL(3, seen);
+
+    CmdLineConfig::RestoreDefaults();
+    CPPUNIT_ASSERT_EQUAL(13, number.load());
+    CPPUNIT_ASSERT_EQUAL(TString("pi"), text);
+
+    // released bindings leave the variables alone
+    number_binding.Release();
+    CPPUNIT_ASSERT(!number_binding.IsBound());
+    view.SetValue("CmdLine.CtxIntArg", "5");
+    CPPUNIT_ASSERT_EQUAL(13, number.load());
+
+    // bindings end with the option
+    Double_t scale = 0.;
+    CmdLineOption* opt = new CmdLineOption("CtxScale", "-scale", "", 0.5);
+    CmdLineBinding scale_binding = opt->Bind(scale);
+    CPPUNIT_ASSERT_EQUAL(0.5, scale);
+    delete opt;
+    CPPUNIT_ASSERT(!scale_binding.IsBound());
+  }
+
+  void Routes() {
+    CmdLineConfig parent(CmdLineConfig::instance());
+    CmdLineConfig view(&parent);
+    CmdLineConfig::Scope scope(&view);
+    parent.SetValue("CmdLine.ParSource.Geometry", "file");
+    parent.SetValue("CmdLine.ParDrain.Geometry", "fileimport");
+    view.SetValue("CmdLine.ParSource.Calib", "fileimport");
+
+    CPPUNIT_ASSERT_EQUAL(kSql, CmdLineConfig::GetParameterSourceType("Other"));
+    CPPUNIT_ASSERT_EQUAL(kFile,
+                         CmdLineConfig::GetParameterSourceType("Geometry"));
+    CPPUNIT_ASSERT_EQUAL(kFileImport,
+                         CmdLineConfig::GetParameterSourceType("Calib"));
+    CPPUNIT_ASSERT_EQUAL(kImportExport,
+                         CmdLineConfig::GetParameterDrainType("Geometry"));
+    CPPUNIT_ASSERT_EQUAL(kFile, CmdLineConfig::GetParameterDrainType("Calib"));
+
+    // changes of the routes and defaults, also in the parent, are seen
+    view.SetValue("CmdLine.ParameterSource", "file");
+    CPPUNIT_ASSERT_EQUAL(kFile, CmdLineConfig::GetParameterSourceType("Other"));
+    parent.SetValue("CmdLine.ParSource.Geometry", "sql");
+    CPPUNIT_ASSERT_EQUAL(kSql,
+                         CmdLineConfig::GetParameterSourceType("Geometry"));
+    {
+      CmdLineConfig::Override override(&view);
+      CmdLineConfig::SetParameterDrain("Calib", "sql");
+      CPPUNIT_ASSERT_EQUAL(kSql, CmdLineConfig::GetParameterDrainType("Calib"));
+    }
+    CPPUNIT_ASSERT_EQUAL(kFile, CmdLineConfig::GetParameterDrainType("Calib"));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ContextCase);
@@ -0,0 +1,134 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <CmdLineConfig.hh>
+#include <CmdLineGlob.hh>
+
+#include <TString.h>
+
+#include <iostream>
+#include <sstream>
+#include <string>
+
+class GlobCase : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(GlobCase);
+  CPPUNIT_TEST(Syntax);
+  CPPUNIT_TEST(Specificity);
+  CPPUNIT_TEST(Options);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  CmdLineOption* gain;
+
+  static std::string Match(CmdLineGlob& glob, const char* name) {
+    const char* pattern = glob.Match(name);
+    return pattern ? pattern : "";
+  }
+
+public:
+  virtual void setUp() override {
+    gain = new CmdLineOption("GlobGain", "", "Gain", 1.0);
+  }
+  virtual void tearDown() override {
+    CmdLineConfig::instance()->ClearOptions();
+  }
+
+protected:
+  void Syntax() {
+    CmdLineGlob glob;
+    glob.Compile({"Det.Ch[0-63].Gain", "Det.{A,B}*.Thr", "Det.**.Ped",
+                  "Det.Ch[007-12].Ped", "Det.L?.[!xy]", "Det.{A,B.C}.X",
+                  "Det.[bad.Gain"});
+    CPPUNIT_ASSERT_EQUAL(size_t(6), glob.GetNPatterns());
+
+    CPPUNIT_ASSERT_EQUAL(std::string("Det.Ch[0-63].Gain"),
+                         Match(glob, "Det.Ch0.Gain"));
+    CPPUNIT_ASSERT_EQUAL(std::string("Det.Ch[0-63].Gain"),
+                         Match(glob, "Det.Ch63.Gain"));
+    CPPUNIT_ASSERT_EQUAL(std::string(), Match(glob, "Det.Ch64.Gain"));
+    CPPUNIT_ASSERT_EQUAL(std::string(), Match(glob, "Det.Ch07.Gain"));
+
+    CPPUNIT_ASSERT_EQUAL(std::string("Det.{A,B}*.Thr"),
+                         Match(glob, "Det.Bottom.Thr"));
+    CPPUNIT_ASSERT_EQUAL(std::string("Det.{A,B}*.Thr"),
+                         Match(glob, "Det.A.Thr"));
+    CPPUNIT_ASSERT_EQUAL(std::string(), Match(glob, "Det.C.Thr"));
+    CPPUNIT_ASSERT_EQUAL(std::string(), Match(glob, "Det.A.B.Thr"));
+
+    CPPUNIT_ASSERT_EQUAL(std::string("Det.**.Ped"),
+                         Match(glob, "Det.A.B.C.Ped"));
+    CPPUNIT_ASSERT_EQUAL(std::string("Det.Ch[007-12].Ped"),
+                         Match(glob, "Det.Ch010.Ped"));
+    CPPUNIT_ASSERT_EQUAL(std::string("Det.**.Ped"),
+                         Match(glob, "Det.Ch10.Ped"));
+
+    CPPUNIT_ASSERT_EQUAL(std::string("Det.L?.[!xy]"),
+                         Match(glob, "Det.L1.z"));
+    CPPUNIT_ASSERT_EQUAL(std::string(), Match(glob, "Det.L1.x"));
+    CPPUNIT_ASSERT_EQUAL(std::string("Det.{A,B.C}.X"),
+                         Match(glob, "Det.B.C.X"));
+  }
+
+  void Specificity() {
+    CmdLineGlob glob;
+    glob.Compile({"CmdLine.**.Gain", "CmdLine.*.*.Gain", "CmdLine.*.B.Gain",
+                  "CmdLine.A.*.Gain", "CmdLine.A.B?.Gain", "CmdLine.A.*",
+                  "*.A.Gain"});
+    // bare '*' as the first or last component is ignored
+    CPPUNIT_ASSERT_EQUAL(size_t(5), glob.GetNPatterns());
+
+    // the leftmost differing component decides
+    CPPUNIT_ASSERT_EQUAL(std::string("CmdLine.A.*.Gain"),
+                         Match(glob, "CmdLine.A.B.Gain"));
+    CPPUNIT_ASSERT_EQUAL(std::string("CmdLine.*.B.Gain"),
+                         Match(glob, "CmdLine.X.B.Gain"));
+    CPPUNIT_ASSERT_EQUAL(std::string("CmdLine.*.*.Gain"),
+                         Match(glob, "CmdLine.X.Y.Gain"));
+    CPPUNIT_ASSERT_EQUAL(std::string("CmdLine.**.Gain"),
+                         Match(glob, "CmdLine.X.Y.Z.Gain"));
+    CPPUNIT_ASSERT_EQUAL(std::string("CmdLine.A.B?.Gain"),
+                         Match(glob, "CmdLine.A.Bx.Gain"));
+    CPPUNIT_ASSERT_EQUAL(std::string("CmdLine.A.*.Gain"),
+                         Match(glob, "CmdLine.A.Y.Gain"));
+  }
+
+  void Options() {
+    CmdLineConfig::ClearValues();
+    CmdLineConfig view(CmdLineConfig::instance());
+    CmdLineConfig::Scope scope(&view);
+
+    CmdLineOption* ch5 = gain->Expand("Det", "Ch5");
+    CmdLineOption* ch70 = gain->Expand("Det", "Ch70");
+    CmdLineOption* ch8 = gain->Expand("Det", "Ch8");
+    view.SetValue("CmdLine.Det.Ch[0-63].GlobGain", "2");
+    view.SetValue("CmdLine.Det.*.GlobGain", "3");
+    CPPUNIT_ASSERT_EQUAL(2., ch5->GetDoubleValue());
+    CPPUNIT_ASSERT_EQUAL(3., ch70->GetDoubleValue());
+
+    // explicit keys and later changes of patterns
+    view.SetValue("CmdLine.Det.Ch8.GlobGain", "4");
+    view.SetValue("CmdLine.Det.Ch[0-63].GlobGain", "5");
+    CPPUNIT_ASSERT_EQUAL(4., ch8->GetDoubleValue());
+    CPPUNIT_ASSERT_EQUAL(5., ch5->GetDoubleValue());
+    view.SetValue("CmdLine.Det.Ch{5,6}.**", "6");
+    CPPUNIT_ASSERT_EQUAL(5., ch5->GetDoubleValue());
+    view.SetValue("CmdLine.Det.Ch5*.GlobGain", "7");
+    CPPUNIT_ASSERT_EQUAL(7., ch5->GetDoubleValue());
+
+    // malformed values of options expanded later are reported once
+    view.SetValue("CmdLine.Det.Ch9*.GlobGain", "x");
+    std::ostringstream err;
+    std::streambuf* cerr = std::cerr.rdbuf(err.rdbuf());
+    CmdLineOption* ch9 = gain->Expand("Det", "Ch9");
+    Double_t ch9gain = ch9->GetDoubleValue();
+    view.SetValue("CmdLine.Det.Ch5*.GlobGain", "8");
+    ch9gain += ch9->GetDoubleValue();
+    std::cerr.rdbuf(cerr);
+    CPPUNIT_ASSERT_EQUAL(2., ch9gain);
+    CPPUNIT_ASSERT_EQUAL(std::string("CmdLineOption: invalid value 'x' of "
+                                     "Det.Ch9.GlobGain at configuration, "
+                                     "using default\n"),
+                         err.str());
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(GlobCase);
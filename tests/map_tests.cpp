@@ -0,0 +1,103 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <CmdLineConfig.hh>
+#include <CmdLineMap.hh>
+
+#include "test_files.hh"
+
+#include <TString.h>
+
+#include <string>
+
+class MapCase : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(MapCase);
+  CPPUNIT_TEST(RawFile);
+  CPPUNIT_TEST(NpyFile);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  CmdLineOption *int_val, *double_val;
+  TestFiles files;
+  TString raw, npy;
+
+public:
+  virtual void setUp() override {
+    int_val = new CmdLineOption("MapIntArg", "-int", "Int Help message", 13);
+    double_val =
+        new CmdLineOption("MapDoubleArg", "-double", "Double Help message", 0.);
+    raw = files.File(".f64");
+    npy = files.File(".npy");
+  }
+  virtual void tearDown() override {
+    CmdLineConfig::instance()->ClearOptions();
+    files.Remove();
+  }
+
+protected:
+  void RawFile() {
+    Double_t gains[1000];
+    for (int i = 0; i < 1000; ++i)
+      gains[i] = 0.5 * i;
+    TestFiles::Write(raw, std::string((const char*)gains, sizeof(gains)));
+
+    TString value = "@" + raw;
+    const char* argv[] = {"./prog", "-double", value.Data()};
+    CmdLineConfig view(CmdLineConfig::instance());
+    view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+
+    CmdLineConfig::Scope scope(&view);
+    CPPUNIT_ASSERT_EQUAL(1000, CmdLineOption::GetArraySize("MapDoubleArg"));
+    CPPUNIT_ASSERT_EQUAL(0.0, CmdLineOption::GetDoubleValue("MapDoubleArg"));
+    CPPUNIT_ASSERT_EQUAL(
+        1.5, CmdLineOption::GetDoubleArrayValue("MapDoubleArg", 4));
+
+    // all contexts share the mapping
+    CmdLineSpan<Double_t> span = CmdLineOption::GetDoubleArray("MapDoubleArg");
+    CPPUNIT_ASSERT_EQUAL(size_t(1000), span.size());
+    CPPUNIT_ASSERT_EQUAL(499.5, span[999]);
+    CPPUNIT_ASSERT(span.data() == CmdLineMap::Open(raw)->GetDoubles().data());
+
+    // wrong type of elements, the default is used
+    const char* argv2[] = {"./prog", "-int", value.Data()};
+    view.ReadCmdLine(sizeof(argv2) / sizeof(char*), (char**)argv2);
+    CPPUNIT_ASSERT_EQUAL(13, CmdLineOption::GetIntValue("MapIntArg"));
+  }
+
+  void NpyFile() {
+    std::string header = "{'descr': '<i4', 'fortran_order': False, "
+                         "'shape': (2, 3), }";
+    while ((10 + header.size() + 1) % 64)
+      header += ' ';
+    header += '\n';
+    std::string data = "\x93NUMPY\x01";
+    data += '\0';
+    data += (char)(header.size() & 0xff);
+    data += (char)(header.size() >> 8);
+    data += header;
+    for (Int_t i = 1; i <= 6; ++i)
+      data.append((const char*)&i, sizeof(i));
+    TestFiles::Write(npy, data);
+
+    std::shared_ptr<CmdLineMap> map = CmdLineMap::Open(npy);
+    CPPUNIT_ASSERT(map);
+    CPPUNIT_ASSERT_EQUAL(CmdLineMap::kInt32, map->GetType());
+    CPPUNIT_ASSERT_EQUAL(size_t(6), map->GetSize());
+    CPPUNIT_ASSERT(map == CmdLineMap::Open(npy));
+
+    TString value = "@" + npy;
+    const char* argv[] = {"./prog", "-int", value.Data()};
+    CmdLineConfig view(CmdLineConfig::instance());
+    view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+
+    CmdLineConfig::Scope scope(&view);
+    CPPUNIT_ASSERT_EQUAL(6, CmdLineOption::GetArraySize("MapIntArg"));
+    CPPUNIT_ASSERT_EQUAL(1, CmdLineOption::GetIntValue("MapIntArg"));
+    CPPUNIT_ASSERT_EQUAL(5, CmdLineOption::GetIntArrayValue("MapIntArg", 5));
+    Int_t sum = 0;
+    for (Int_t v : CmdLineOption::GetIntArray("MapIntArg"))
+      sum += v;
+    CPPUNIT_ASSERT_EQUAL(21, sum);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(MapCase);
@@ -0,0 +1,188 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <CmdLineConfig.hh>
+#include <CmdLineRcFile.hh>
+
+#include "test_files.hh"
+
+#include <TEnv.h>
+#include <TString.h>
+
+#include <cstdlib>
+#include <string>
+
+class RcFileCase : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(RcFileCase);
+  CPPUNIT_TEST(Conformance);
+  CPPUNIT_TEST(Levels);
+  CPPUNIT_TEST(Records);
+  CPPUNIT_TEST(Async);
+  CPPUNIT_TEST(Append);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  TestFiles files;
+  TString first, second, dir;
+
+  // all records of both environments are the same
+  static void Compare(TEnv& expected, TEnv& env) {
+    CPPUNIT_ASSERT_EQUAL(expected.GetTable()->GetSize(),
+                         env.GetTable()->GetSize());
+    TIter it(expected.GetTable());
+    TEnvRec* rec;
+    while ((rec = dynamic_cast<TEnvRec*>(it.Next()))) {
+      TEnvRec* other = env.Lookup(rec->GetName());
+      CPPUNIT_ASSERT(other != nullptr);
+      CPPUNIT_ASSERT_EQUAL(std::string(rec->GetValue()),
+                           std::string(other->GetValue()));
+      CPPUNIT_ASSERT_EQUAL((int)rec->GetLevel(), (int)other->GetLevel());
+    }
+  }
+
+public:
+  virtual void setUp() override {
+    first = files.File("-1.rc");
+    second = files.File("-2.rc");
+    dir = files.Dir(".d");
+    setenv("CMDLINE_TEST_DIR", "/data/run", 1);
+  }
+  virtual void tearDown() override {
+    files.Remove();
+  }
+
+protected:
+  void Conformance() {
+    // rc files as they are written, and the corner cases of the syntax
+    const char* corpus[] = {
+        "# detector setup\n"
+        "CmdLine.DataDir:      $(CMDLINE_TEST_DIR)/share\n"
+        "CmdLine.Include:  geometry.rc   calibration.rc\n"
+        "\n"
+        "   # indented comment\n"
+        "CmdLine.Det.*.Gain:   1.25\n"
+        "CmdLine.Det.Ch[0-63].Thr:\t20\n"
+        "+CmdLine.Include:     extra.rc\n"
+        "+CmdLine.NewList:     a\n"
+        "CmdLine.Trailing:     value with blanks   \n",
+        "Unix.*.Root.DynamicPath:  .:$(ROOTSYS)/lib\n"
+        "Key : value after colon\n"
+        "Key2\t\tvalue\n"
+        "Typed(int): 5\n"
+        "Typed2(double) 6\n"
+        "Typed3(unclosed\n"
+        "NoValue\n"
+        "NoValue2:\n"
+        ":colon\n"
+        "Windows:  crlf\r\n"
+        "Undefined: $(CMDLINE_UNDEFINED_VAR)/x\n"
+        "Mixed: $(CMDLINE_TEST_DIR)/$(CMDLINE_UNDEFINED_VAR)\n"
+        "Last: no newline",
+        "",
+        "\n\n#\n   \n",
+    };
+
+    for (size_t i = 0; i < sizeof(corpus) / sizeof(char*); ++i) {
+      TestFiles::Write(first, corpus[i]);
+      for (int level = kEnvGlobal; level <= kEnvChange; ++level) {
+        TEnv expected, env;
+        CPPUNIT_ASSERT_EQUAL(expected.ReadFile(first, (EEnvLevel)level),
+                             CmdLineRcFile::ReadFile(&env, first,
+                                                     (EEnvLevel)level));
+        Compare(expected, env);
+      }
+    }
+
+    TEnv env;
+    CPPUNIT_ASSERT_EQUAL(-1,
+                         CmdLineRcFile::ReadFile(&env, "/nonexistent.rc",
+                                                 kEnvUser));
+  }
+
+  void Levels() {
+    // duplicates of a level are ignored, kEnvChange overwrites, '+' appends
+    TestFiles::Write(first, "A: 1\n"
+                            "A: 2\n"
+                            "B: x\n"
+                            "+B: y\n");
+    TestFiles::Write(second, "A: 3\n"
+                             "+B: z\n"
+                             "C: 4\n");
+
+    EEnvLevel levels[][2] = {{kEnvGlobal, kEnvGlobal},
+                             {kEnvGlobal, kEnvUser},
+                             {kEnvUser, kEnvChange},
+                             {kEnvChange, kEnvChange}};
+    for (size_t i = 0; i < sizeof(levels) / sizeof(levels[0]); ++i) {
+      TEnv expected, env;
+      expected.ReadFile(first, levels[i][0]);
+      expected.ReadFile(second, levels[i][1]);
+      CmdLineRcFile::ReadFile(&env, first, levels[i][0]);
+      CmdLineRcFile::ReadFile(&env, second, levels[i][1]);
+      Compare(expected, env);
+    }
+  }
+
+  void Records() {
+    CmdLineRcFile file;
+    std::string text = "+List(string): a b\n"
+                       "Path: $(HOME)\n";
+    file.Parse(text.data(), text.size());
+    CPPUNIT_ASSERT_EQUAL(size_t(2), file.GetRecords().size());
+    CPPUNIT_ASSERT_EQUAL(std::string("+List"),
+                         std::string(file.GetRecords()[0].fName));
+    CPPUNIT_ASSERT_EQUAL(std::string("string"),
+                         std::string(file.GetRecords()[0].fType));
+    CPPUNIT_ASSERT_EQUAL(std::string("a b"),
+                         std::string(file.GetRecords()[0].fValue));
+    // variables are expanded when the records are set
+    CPPUNIT_ASSERT_EQUAL(std::string("$(HOME)"),
+                         std::string(file.GetRecords()[1].fValue));
+  }
+
+  void Async() {
+    // a file of the default path includes another, the local file is last
+    TestFiles::Write(dir + "/a.rc", std::string("CmdLine.AsyncA: 1\n"
+                                                "CmdLine.Include: ") +
+                                        second.Data() + "\n");
+    TestFiles::Write(second, "CmdLine.AsyncB: 2\n");
+    TestFiles::Write(first, "CmdLine.AsyncA: 3\n");
+
+    for (int mode = 0; mode < 3; ++mode) {
+      RcConfig cfg(first);
+      CmdLineConfig::Scope scope(&cfg);
+      // options the files depend on are defined before or after the start
+      if (mode == 2) cfg.LoadAsync();
+      CmdLineOption path("DefaultPath", "", "", dir.Data());
+      CmdLineOption include("Include", "", "", "");
+      if (mode == 1) cfg.LoadAsync();
+
+      CPPUNIT_ASSERT_EQUAL(std::string("3"),
+                           std::string(cfg.GetValue("CmdLine.AsyncA", "")));
+      CPPUNIT_ASSERT_EQUAL(std::string("2"),
+                           std::string(cfg.GetValue("CmdLine.AsyncB", "")));
+    }
+  }
+  void Append() {
+    // values appended in the local and in an extra file, to a key of the
+    // default path
+    TestFiles::Write(dir + "/a.rc", "CmdLine.RcList: a\n");
+    TestFiles::Write(first, "+CmdLine.RcList: b\n");
+    TestFiles::Write(second, "+CmdLine.RcList: c\n");
+
+    RcConfig cfg(first);
+    CmdLineConfig::Scope scope(&cfg);
+    CmdLineOption path("DefaultPath", "", "", dir.Data());
+    CmdLineOption list("RcList", "", "", "");
+    // the name of the extra file is left as a positional argument
+    CmdLineArg files("", "files", CmdLineArg::kString);
+    CPPUNIT_ASSERT_EQUAL(std::string("a b"),
+                         std::string(list.GetStringValue()));
+
+    const char* argv[] = {"./prog", "-extra-sorterrc", second.Data()};
+    cfg.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+    CPPUNIT_ASSERT_EQUAL(std::string("a b c"),
+                         std::string(list.GetStringValue()));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(RcFileCase);
@@ -0,0 +1,91 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <CmdLineConfig.hh>
+#include <CmdLineResolver.hh>
+
+#include "test_files.hh"
+
+#include <TString.h>
+
+#include <chrono>
+#include <thread>
+
+#include <unistd.h>
+
+class ResolverCase : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(ResolverCase);
+  CPPUNIT_TEST(Resolve);
+  CPPUNIT_TEST(Invalidation);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  TestFiles files;
+  TString first, second, path;
+
+  // directory times are taken from a coarse clock
+  static void Tick() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+  }
+
+public:
+  virtual void setUp() override {
+    first = files.Dir("-a");
+    second = files.Dir("-b");
+    path = first + ":" + second;
+  }
+  virtual void tearDown() override { files.Remove(); }
+
+protected:
+  void Resolve() {
+    TestFiles::Touch(second + "/geo.dat");
+    TestFiles::Touch(first + "/calib.dat");
+    TestFiles::Touch(second + "/calib.dat");
+
+    for (int index = 0; index < 2; ++index) {
+      CmdLineResolver resolver;
+      resolver.SetIndex(index);
+      for (int i = 0; i < 2; ++i) {
+        CPPUNIT_ASSERT_EQUAL(std::string((second + "/geo.dat").Data()),
+                             std::string(resolver.Resolve(path, "geo.dat")));
+        CPPUNIT_ASSERT_EQUAL(std::string((first + "/calib.dat").Data()),
+                             std::string(resolver.Resolve(path, "calib.dat")));
+        CPPUNIT_ASSERT(resolver.Resolve(path, "none.dat").IsNull());
+        CPPUNIT_ASSERT(resolver.Resolve(path, "geo.dat", kExecutePermission)
+                           .IsNull());
+      }
+      CPPUNIT_ASSERT_EQUAL(size_t(4), resolver.GetNEntries());
+    }
+
+    CPPUNIT_ASSERT_EQUAL(std::string((second + "/geo.dat").Data()),
+                         std::string(CmdLineConfig::GetResource(path,
+                                                                "geo.dat")));
+  }
+
+  void Invalidation() {
+    CmdLineResolver resolver;
+    resolver.SetIndex(kTRUE);
+    CPPUNIT_ASSERT(resolver.Resolve(path, "new.dat").IsNull());
+
+    // misses are kept until invalidated
+    TestFiles::Touch(second + "/new.dat");
+    CPPUNIT_ASSERT(resolver.Resolve(path, "new.dat").IsNull());
+    resolver.Invalidate();
+    CPPUNIT_ASSERT_EQUAL(std::string((second + "/new.dat").Data()),
+                         std::string(resolver.Resolve(path, "new.dat")));
+
+    // or until a directory was modified
+    resolver.SetValidation(1);
+    CPPUNIT_ASSERT(!resolver.Resolve(path, "new.dat").IsNull());
+    Tick();
+    TestFiles::Touch(first + "/new.dat");
+    Tick();
+    CPPUNIT_ASSERT_EQUAL(std::string((first + "/new.dat").Data()),
+                         std::string(resolver.Resolve(path, "new.dat")));
+    unlink(first + "/new.dat");
+    Tick();
+    CPPUNIT_ASSERT_EQUAL(std::string((second + "/new.dat").Data()),
+                         std::string(resolver.Resolve(path, "new.dat")));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(ResolverCase);
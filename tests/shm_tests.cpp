@@ -0,0 +1,84 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <CmdLineConfig.hh>
+#include <CmdLineShm.hh>
+
+#include "test_files.hh"
+
+#include <TEnv.h>
+#include <TString.h>
+
+class SharedCase : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(SharedCase);
+  CPPUNIT_TEST(PublishAttach);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  CmdLineOption* int_val;
+
+public:
+  virtual void setUp() override {
+    int_val = new CmdLineOption("ShmIntArg", "-int", "Int Help message", 13);
+  }
+  virtual void tearDown() override {
+    CmdLineConfig::instance()->ClearOptions();
+  }
+
+protected:
+  void PublishAttach() {
+    // the server is mocked in the test process
+    TString name = TestFiles::Name("");
+    CmdLineShm server(name);
+    TEnv env("");
+    env.SetValue("CmdLine.ShmIntArg", "5");
+    env.SetValue("CmdLine.Other", "text");
+    CPPUNIT_ASSERT(server.Publish(&env));
+    CPPUNIT_ASSERT(server.Listen());
+
+    CmdLineShm client(name);
+    CPPUNIT_ASSERT(client.Connect());
+    CPPUNIT_ASSERT(client.Attach());
+    CPPUNIT_ASSERT_EQUAL(ULong64_t(1), client.GetVersion());
+    CPPUNIT_ASSERT_EQUAL(UInt_t(2), client.GetNRecords());
+    CPPUNIT_ASSERT(!client.IsStale());
+
+    CmdLineConfig view(CmdLineConfig::instance());
+    CPPUNIT_ASSERT(view.AttachSharedEnv(name));
+    int changes = 0;
+    view.AddCallback([&changes](const ChangedOptions& changed) {
+      changes += changed.size();
+    });
+    {
+      CmdLineConfig::Scope scope(&view);
+      CPPUNIT_ASSERT_EQUAL(5, CmdLineOption::GetIntValue("ShmIntArg"));
+      CPPUNIT_ASSERT_EQUAL(std::string("text"),
+                           std::string(view.GetValue("CmdLine.Other", "")));
+    }
+    CPPUNIT_ASSERT(!view.SyncSharedEnv());
+    // records of the old version may still be read by other threads
+    const char* other = view.GetValue("CmdLine.Other", "");
+
+    env.SetValue("CmdLine.ShmIntArg", "7");
+    CPPUNIT_ASSERT(server.Publish(&env));
+    server.Notify();
+
+    CPPUNIT_ASSERT_EQUAL(ULong64_t(2), client.WaitUpdate(1000));
+    CPPUNIT_ASSERT(client.IsStale());
+    CPPUNIT_ASSERT(client.Attach());
+    CPPUNIT_ASSERT_EQUAL(ULong64_t(2), client.GetVersion());
+
+    CPPUNIT_ASSERT(view.SyncSharedEnv());
+    CPPUNIT_ASSERT_EQUAL(1, changes);
+    CPPUNIT_ASSERT_EQUAL(std::string("text"), std::string(other));
+    {
+      CmdLineConfig::Scope scope(&view);
+      CPPUNIT_ASSERT_EQUAL(7, CmdLineOption::GetIntValue("ShmIntArg"));
+    }
+
+    server.Unlink();
+    CmdLineShm gone(name);
+    CPPUNIT_ASSERT(!gone.Attach());
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SharedCase);
@@ -0,0 +1,129 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <CmdLineConfig.hh>
+
+#include <TString.h>
+
+class StateCase : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(StateCase);
+  CPPUNIT_TEST(RoundTrip);
+  CPPUNIT_TEST(Snapshots);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  CmdLineOption* int_val;
+  CmdLineOption* double_val;
+  CmdLineOption* string_val;
+  CmdLineArg *arg1, *greedy, *arg2;
+
+public:
+  virtual void setUp() override {
+    int_val = new CmdLineOption("StIntArg", "-int", "Int Help message", 13);
+    double_val = new CmdLineOption("StDoubleArg", "-double",
+                                   "Double Help message", 3.1415);
+    string_val =
+        new CmdLineOption("StStringArg", "-string", "String Help message", "pi");
+
+    arg1 = new CmdLineArg("arg1", "first", CmdLineArg::kString);
+    greedy = new CmdLineArg("", "greedy", CmdLineArg::kString);
+    arg2 = new CmdLineArg("arg2", "second", CmdLineArg::kString);
+  }
+  virtual void tearDown() override {
+    CmdLineConfig::instance()->ClearOptions();
+  }
+
+protected:
+  void RoundTrip() {
+    CmdLineState state;
+    {
+      const char* argv[] = {"./prog", "-int",    "42",  "-double", "0.1",
+                            "pos1",   "greedy1", "greedy2", "pos2"};
+      CmdLineConfig::instance()->ReadCmdLine(sizeof(argv) / sizeof(char*),
+                                             (char**)argv);
+      CmdLineConfig::instance()->SaveState(state);
+    }
+
+    CPPUNIT_ASSERT_EQUAL(std::string("42"),
+                         std::string(state.GetOptionValue("StIntArg")));
+    CPPUNIT_ASSERT_EQUAL(std::string("pi"),
+                         std::string(state.GetOptionValue("StStringArg")));
+    CPPUNIT_ASSERT_EQUAL(2, state.GetNArguments());
+    CPPUNIT_ASSERT_EQUAL(2, state.GetNGreedy());
+
+    {
+      const char* argv[] = {"./prog", "-int", "7", "-string", "e", "a", "b"};
+      CmdLineConfig::instance()->ReadCmdLine(sizeof(argv) / sizeof(char*),
+                                             (char**)argv);
+      CPPUNIT_ASSERT_EQUAL(7, CmdLineOption::GetIntValue("StIntArg"));
+    }
+
+    CmdLineConfig::instance()->LoadState(state);
+
+    CPPUNIT_ASSERT_EQUAL(42, CmdLineOption::GetIntValue("StIntArg"));
+    CPPUNIT_ASSERT_EQUAL(0.1, CmdLineOption::GetDoubleValue("StDoubleArg"));
+    CPPUNIT_ASSERT_EQUAL(
+        std::string("pi"),
+        std::string(CmdLineOption::GetStringValue("StStringArg")));
+
+    const Positional& pargs =
+        CmdLineConfig::instance()->GetPositionalArguments();
+    CPPUNIT_ASSERT_EQUAL(TString("pos1"),
+                         TString(pargs.at("arg1")->GetStringValue()));
+    CPPUNIT_ASSERT_EQUAL(TString("pos2"),
+                         TString(pargs.at("arg2")->GetStringValue()));
+
+    const Greedy& gargs = CmdLineConfig::instance()->GetGreedyArguments();
+    CPPUNIT_ASSERT_EQUAL(2, (int)gargs.size());
+    CPPUNIT_ASSERT_EQUAL(TString("greedy2"),
+                         TString(gargs[1]->GetStringValue()));
+  }
+
+  void Snapshots() {
+    CmdLineConfig view(CmdLineConfig::instance());
+    CmdLineConfig::Scope scope(&view);
+    const char* argv[] = {"./prog", "-int", "42", "pos1", "pos2"};
+    view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+    for (int i = 0; i < 1000; ++i)
+      view.SetValue(TString::Format("Tuning.Par%d", i), "0");
+
+    CmdLineSnapshot base = view.Snapshot();
+    CPPUNIT_ASSERT_EQUAL(size_t(1001), base.GetNValues());
+
+    // the state of a child context holds the options of its parent
+    CmdLineState state;
+    view.SaveState(state);
+    CPPUNIT_ASSERT_EQUAL(std::string("42"),
+                         std::string(state.GetOptionValue("StIntArg")));
+    CPPUNIT_ASSERT_EQUAL(std::string("pi"),
+                         std::string(state.GetOptionValue("StStringArg")));
+
+    int changes = 0;
+    view.AddCallback([&changes](const ChangedOptions& changed) {
+      changes += changed.size();
+    });
+
+    // a branch of the configuration
+    view.SetValue("CmdLine.StIntArg", "7");
+    view.SetValue("Tuning.Par5", "1");
+    view.SetValue("Tuning.Extra", "1");
+    CmdLineSnapshot branch = view.Snapshot();
+    CPPUNIT_ASSERT_EQUAL(7, CmdLineOption::GetIntValue("StIntArg"));
+    CPPUNIT_ASSERT_EQUAL(std::string("0"),
+                         std::string(base.GetValue(1, "Tuning.Par5")));
+
+    view.Restore(base);
+    CPPUNIT_ASSERT_EQUAL(42, CmdLineOption::GetIntValue("StIntArg"));
+    CPPUNIT_ASSERT_EQUAL(std::string("0"),
+                         std::string(view.GetValue("Tuning.Par5", "")));
+    CPPUNIT_ASSERT(!view.Lookup("Tuning.Extra"));
+    CPPUNIT_ASSERT_EQUAL(1, changes);
+
+    view.Restore(branch);
+    CPPUNIT_ASSERT_EQUAL(7, CmdLineOption::GetIntValue("StIntArg"));
+    CPPUNIT_ASSERT_EQUAL(std::string("1"),
+                         std::string(view.GetValue("Tuning.Extra", "")));
+    CPPUNIT_ASSERT_EQUAL(2, changes);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(StateCase);
@@ -0,0 +1,100 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <CmdLineConfig.hh>
+
+#include <TString.h>
+
+class SubcommandCase : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(SubcommandCase);
+  CPPUNIT_TEST(Select);
+  CPPUNIT_TEST(Contexts);
+  CPPUNIT_TEST(Expanded);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  CmdLineOption* verbose;
+  int n_merge, n_split;
+
+public:
+  virtual void setUp() override {
+    verbose = new CmdLineOption("SubVerbose", "-v", "Verbose output");
+    n_merge = n_split = 0;
+
+    CmdLineConfig* cfg = CmdLineConfig::instance();
+    cfg->AddSubcommand("merge", "merge files", [this](CmdLineConfig& cmd) {
+      ++n_merge;
+      cmd.New<CmdLineOption>("MergeOutput", "-o", "output file", "out.root");
+      cmd.New<CmdLineArg>("", "input files", CmdLineArg::kString);
+    });
+    cfg->AddSubcommand("split", "split files", [this](CmdLineConfig& cmd) {
+      ++n_split;
+      cmd.New<CmdLineOption>("SplitParts", "-n", "number of parts", 2);
+      cmd.New<CmdLineArg>("input", "input file", CmdLineArg::kString);
+    });
+    cfg->AddSubcommand("fill", "fill histograms", [](CmdLineConfig& cmd) {
+      CmdLineOption* bins = cmd.New<CmdLineOption>("FillBins", "", "", 100);
+      bins->Expand("TH1I", "h1");
+    });
+  }
+  virtual void tearDown() override {
+    CmdLineConfig::instance()->ClearOptions();
+  }
+
+protected:
+  void Select() {
+    const char* argv[] = {"./prog", "-v",   "merge", "-o",
+                          "all.root", "a.root", "b.root"};
+    CmdLineConfig::instance()->ReadCmdLine(sizeof(argv) / sizeof(char*),
+                                           (char**)argv);
+
+    CPPUNIT_ASSERT_EQUAL(1, n_merge);
+    CPPUNIT_ASSERT_EQUAL(0, n_split);
+    CPPUNIT_ASSERT_EQUAL(TString("merge"),
+                         CmdLineConfig::instance()->GetSubcommand());
+    CPPUNIT_ASSERT_EQUAL(true, CmdLineOption::GetFlagValue("SubVerbose"));
+    CPPUNIT_ASSERT_EQUAL(
+        std::string("all.root"),
+        std::string(CmdLineOption::GetStringValue("MergeOutput")));
+    CPPUNIT_ASSERT(!CmdLineConfig::FindOption("SplitParts"));
+    CPPUNIT_ASSERT_EQUAL(size_t(2),
+                         CmdLineConfig::GetGreedyArguments().size());
+
+    CmdLineConfig::PrintHelp(0, nullptr);
+  }
+
+  void Contexts() {
+    {
+      CmdLineConfig view(CmdLineConfig::instance());
+      const char* argv[] = {"./prog", "split", "-n", "4", "c.root"};
+      view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+
+      CmdLineConfig::Scope scope(&view);
+      CPPUNIT_ASSERT_EQUAL(TString("split"), view.GetSubcommand());
+      CPPUNIT_ASSERT_EQUAL(4, CmdLineOption::GetIntValue("SplitParts"));
+      CPPUNIT_ASSERT_EQUAL(TString("c.root"),
+                           TString(CmdLineArg::GetStringValue("input")));
+    }
+
+    // the options of the subcommand were deleted with the context
+    CPPUNIT_ASSERT_EQUAL(1, n_split);
+    CPPUNIT_ASSERT(!CmdLineConfig::FindOption("SplitParts"));
+    CPPUNIT_ASSERT(CmdLineConfig::instance()->GetSubcommand().IsNull());
+  }
+
+  void Expanded() {
+    {
+      CmdLineConfig view(CmdLineConfig::instance());
+      const char* argv[] = {"./prog", "fill"};
+      view.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+
+      CmdLineConfig::Scope scope(&view);
+      CPPUNIT_ASSERT_EQUAL(100,
+                           CmdLineOption::GetIntValue("TH1I.h1.FillBins"));
+    }
+
+    // expanded options made by a factory are released with the arena
+    CPPUNIT_ASSERT(!CmdLineConfig::FindOption("TH1I.h1.FillBins"));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SubcommandCase);
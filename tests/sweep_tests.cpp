@@ -0,0 +1,82 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <CmdLineConfig.hh>
+#include <CmdLineSweep.hh>
+
+#include <TString.h>
+
+#include <mutex>
+#include <set>
+
+class SweepCase : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(SweepCase);
+  CPPUNIT_TEST(Grid);
+  CPPUNIT_TEST(Arrays);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  CmdLineOption *int_val, *double_val, *string_val;
+
+public:
+  virtual void setUp() override {
+    int_val = new CmdLineOption("SweepInt", "-int", "Int Help message", 1);
+    double_val =
+        new CmdLineOption("SweepDouble", "-double", "Double Help message", 0.);
+    string_val = new CmdLineOption("SweepString", "-string",
+                                   "String Help message", "none");
+  }
+  virtual void tearDown() override {
+    CmdLineConfig::instance()->ClearOptions();
+  }
+
+protected:
+  void Grid() {
+    const char* argv[] = {"./prog", "-int",    "{3,5,7}", "-double",
+                          "{0.1:0.3:0.1}", "-string", "text"};
+    CmdLineSweep sweep;
+    sweep.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(2), sweep.GetNAxes());
+    CPPUNIT_ASSERT_EQUAL(size_t(3), sweep.GetNValues(1));
+    CPPUNIT_ASSERT_EQUAL(size_t(9), sweep.GetNPoints());
+    CPPUNIT_ASSERT_EQUAL(TString("5"), sweep.GetValue(3, 0));
+    CPPUNIT_ASSERT_EQUAL(TString("0.1"), sweep.GetValue(3, 1));
+
+    std::mutex mutex;
+    std::set<TString> points;
+    sweep.Run(
+        [&](CmdLineConfig&, size_t) {
+          TString point = TString::Format(
+              "%d %g %s", CmdLineOption::GetIntValue("SweepInt"),
+              CmdLineOption::GetDoubleValue("SweepDouble"),
+              CmdLineOption::GetStringValue("SweepString"));
+          std::lock_guard<std::mutex> lock(mutex);
+          points.insert(point);
+        },
+        4);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(9), points.size());
+    CPPUNIT_ASSERT(points.count("3 0.1 text"));
+    CPPUNIT_ASSERT(points.count("7 0.3 text"));
+  }
+
+  void Arrays() {
+    // ranges are given in braces
+    const char* argv[] = {"./prog", "-int", "1:2:3", "-double", "0.5"};
+    CmdLineSweep sweep;
+    sweep.ReadCmdLine(sizeof(argv) / sizeof(char*), (char**)argv);
+
+    CPPUNIT_ASSERT_EQUAL(size_t(0), sweep.GetNAxes());
+    CPPUNIT_ASSERT_EQUAL(size_t(1), sweep.GetNPoints());
+
+    int calls = 0;
+    sweep.Run([&calls](CmdLineConfig&, size_t) {
+      ++calls;
+      CPPUNIT_ASSERT_EQUAL(3, CmdLineOption::GetIntArrayValue("SweepInt", 3));
+      CPPUNIT_ASSERT_EQUAL(0.5, CmdLineOption::GetDoubleValue("SweepDouble"));
+    }, 1);
+    CPPUNIT_ASSERT_EQUAL(1, calls);
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(SweepCase);
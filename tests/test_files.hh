@@ -0,0 +1,82 @@
+#ifndef _TEST_FILES_HH
+#define _TEST_FILES_HH
+
+#include <CmdLineConfig.hh>
+
+#include <TString.h>
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Temporary files of a test case, named after the process so that runs in
+// parallel do not collide. The fixture calls Remove() in tearDown().
+class TestFiles {
+public:
+  /// "cmdline-test-<pid><suffix>", e.g. for a shared memory segment.
+  static TString Name(const char* suffix) {
+    return TString::Format("cmdline-test-%d%s", (int)getpid(), suffix);
+  }
+
+  /// Path of a file in /tmp, removed by Remove().
+  TString File(const char* suffix) {
+    TString path = "/tmp/" + Name(suffix);
+    fFiles.push_back(path);
+    return path;
+  }
+
+  /// Directory in /tmp, made at once and removed with its files.
+  TString Dir(const char* suffix) {
+    TString path = "/tmp/" + Name(suffix);
+    mkdir(path, 0755);
+    fDirs.push_back(path);
+    return path;
+  }
+
+  void Remove() {
+    for (size_t i = 0; i < fFiles.size(); ++i)
+      unlink(fFiles[i]);
+    for (size_t i = 0; i < fDirs.size(); ++i) {
+      DIR* dir = opendir(fDirs[i]);
+      struct dirent* entry;
+      while (dir && (entry = readdir(dir)))
+        if (strcmp(entry->d_name, ".") && strcmp(entry->d_name, ".."))
+          unlink(fDirs[i] + "/" + entry->d_name);
+      if (dir) closedir(dir);
+      rmdir(fDirs[i]);
+    }
+    fFiles.clear();
+    fDirs.clear();
+  }
+
+  /// Replaces the file in one step, like editors do.
+  static void Write(const char* path, const std::string& data) {
+    TString tmp = TString(path) + ".tmp";
+    FILE* f = fopen(tmp, "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+    rename(tmp, path);
+  }
+
+  static void Touch(const char* path) {
+    FILE* f = fopen(path, "w");
+    fclose(f);
+  }
+
+private:
+  std::vector<TString> fFiles;
+  std::vector<TString> fDirs;
+};
+
+// context reading rc files of its own name
+class RcConfig : public CmdLineConfig {
+public:
+  RcConfig(const char* name) : CmdLineConfig(name) {}
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include <cppunit/extensions/HelperMacros.h>
+
+#include <CmdLineConfig.hh>
+#include <CmdLineWatch.hh>
+
+#include "test_files.hh"
+
+#include <TString.h>
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+class WatchCase : public CppUnit::TestFixture {
+  CPPUNIT_TEST_SUITE(WatchCase);
+  CPPUNIT_TEST(Update);
+  CPPUNIT_TEST(Files);
+  CPPUNIT_TEST(Readers);
+  CPPUNIT_TEST_SUITE_END();
+
+private:
+  TestFiles files;
+  TString rcfile, fifo;
+
+public:
+  virtual void setUp() override {
+    rcfile = files.File("-watch.rc");
+    fifo = files.File(".fifo");
+  }
+  virtual void tearDown() override { files.Remove(); }
+
+protected:
+  void Update() {
+    CmdLineConfig view(CmdLineConfig::instance());
+    CmdLineConfig::Scope scope(&view);
+    CmdLineOption a("WatchA", "", "", 1);
+    CmdLineOption b("WatchB", "", "", 2);
+    CmdLineOption c("Det.Ch1.WatchC", "", "", 3);
+
+    Int_t calls = 0;
+    size_t changed = 0;
+    view.AddCallback([&](const ChangedOptions& options) {
+      ++calls;
+      changed = options.size();
+    });
+
+    KeyValues values;
+    values.push_back(std::make_pair("CmdLine.WatchA", "5"));
+    values.push_back(std::make_pair("CmdLine.WatchB", "2"));
+    values.push_back(std::make_pair("CmdLine.Det.*.WatchC", "7"));
+    CPPUNIT_ASSERT_EQUAL(3, view.Update(values));
+    CPPUNIT_ASSERT_EQUAL(1, calls);
+    CPPUNIT_ASSERT_EQUAL(size_t(3), changed);
+    CPPUNIT_ASSERT_EQUAL(5, a.GetIntValue());
+    CPPUNIT_ASSERT_EQUAL(7, c.GetIntValue());
+
+    // unchanged values are not reported
+    CPPUNIT_ASSERT_EQUAL(0, view.Update(values));
+    CPPUNIT_ASSERT_EQUAL(1, calls);
+  }
+
+  void Files() {
+    TestFiles::Write(rcfile, "CmdLine.WatchA: 1\nCmdLine.WatchB: 2\n"
+                             "CmdLine.WatchC: 8\n");
+    RcConfig cfg(rcfile);
+    CmdLineConfig::Scope scope(&cfg);
+    CmdLineOption a("WatchA", "", "", 0);
+    CmdLineOption b("WatchB", "", "", 0);
+    CmdLineOption c("WatchC", "", "", 0);
+    CmdLineConfig view(&cfg);
+    CPPUNIT_ASSERT_EQUAL(1, a.GetIntValue());
+    CPPUNIT_ASSERT_EQUAL(8, c.GetIntValue());
+    CPPUNIT_ASSERT_EQUAL(std::string("8"),
+                         std::string(view.GetValue("CmdLine.WatchC", "")));
+
+    Int_t calls = 0;
+    size_t changed = 0;
+    cfg.AddCallback([&](const ChangedOptions& options) {
+      ++calls;
+      changed = options.size();
+    });
+
+    CmdLineWatch watch(&cfg);
+    CPPUNIT_ASSERT(watch.Start());
+    CPPUNIT_ASSERT(watch.OpenFifo(fifo));
+    CPPUNIT_ASSERT_EQUAL(0, watch.Poll(0));
+
+    // a file and a value changed together are one batch
+    TestFiles::Write(rcfile, "CmdLine.WatchA: 3\nCmdLine.WatchB: 2\n"
+                             "CmdLine.WatchC: 8\n");
+    int fd = open(fifo, O_WRONLY | O_NONBLOCK);
+    const char* line = "WatchB = 4\n";
+    CPPUNIT_ASSERT_EQUAL((ssize_t)strlen(line), write(fd, line, strlen(line)));
+    close(fd);
+    CPPUNIT_ASSERT_EQUAL(2, watch.Poll(1000));
+    CPPUNIT_ASSERT_EQUAL(1, calls);
+    CPPUNIT_ASSERT_EQUAL(size_t(2), changed);
+    CPPUNIT_ASSERT_EQUAL(3, a.GetIntValue());
+    CPPUNIT_ASSERT_EQUAL(4, b.GetIntValue());
+    // unchanged keys are taken from the new records
+    CPPUNIT_ASSERT_EQUAL(8, c.GetIntValue());
+    CPPUNIT_ASSERT_EQUAL(std::string("8"),
+                         std::string(view.GetValue("CmdLine.WatchC", "")));
+
+    // the runtime value stays above the file
+    TestFiles::Write(rcfile, "CmdLine.WatchA: 3\nCmdLine.WatchB: 5\n"
+                             "CmdLine.WatchC: 8\n");
+    CPPUNIT_ASSERT_EQUAL(1, watch.Poll(1000));
+    CPPUNIT_ASSERT_EQUAL(4, b.GetIntValue());
+  }
+
+  void Readers() {
+    TestFiles::Write(rcfile, "CmdLine.WatchA: 0\nCmdLine.WatchB: 0\n");
+    RcConfig cfg(rcfile);
+    CmdLineWatch watch(&cfg);
+    CPPUNIT_ASSERT(watch.Start());
+    CPPUNIT_ASSERT(watch.OpenFifo(fifo));
+    CPPUNIT_ASSERT_EQUAL(std::string("0"),
+                         std::string(cfg.GetValue("CmdLine.WatchA", "")));
+
+    // the records replaced by Poll() are still read in another thread
+    std::atomic<bool> done(false);
+    std::atomic<int> reads(0), missing(0);
+    std::thread reader([&]() {
+      while (!done) {
+        std::string a = cfg.GetValue("CmdLine.WatchA", "");
+        std::string b = cfg.GetValue("CmdLine.WatchB", "");
+        if (a.empty() || b.empty()) ++missing;
+        ++reads;
+      }
+    });
+    while (!reads)
+      std::this_thread::yield();
+
+    for (int i = 1; i <= 20; ++i) {
+      TestFiles::Write(rcfile,
+                       TString::Format("CmdLine.WatchA: %d\n"
+                                       "CmdLine.WatchB: 0\n",
+                                       i).Data());
+      TString line = TString::Format("WatchB = %d\n", i);
+      int fd = open(fifo, O_WRONLY | O_NONBLOCK);
+      CPPUNIT_ASSERT_EQUAL((ssize_t)line.Length(),
+                           write(fd, line.Data(), line.Length()));
+      close(fd);
+      CPPUNIT_ASSERT_EQUAL(2, watch.Poll(1000));
+    }
+    done = true;
+    reader.join();
+
+    CPPUNIT_ASSERT_EQUAL(0, (int)missing);
+    CPPUNIT_ASSERT_EQUAL(std::string("20"),
+                         std::string(cfg.GetValue("CmdLine.WatchA", "")));
+    CPPUNIT_ASSERT_EQUAL(std::string("20"),
+                         std::string(cfg.GetValue("CmdLine.WatchB", "")));
+  }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(WatchCase);